@@ -0,0 +1,137 @@
+#ifndef CPPCIA_BINARY_GRAPH_HPP
+#define CPPCIA_BINARY_GRAPH_HPP
+
+#include "cppcia/frozen_graph.hpp"
+#include "cppcia/graph_util.hpp"
+#include "cppcia/reference.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include <clangd/index/SymbolID.h>
+#include <graaflib/types.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+namespace cppcia {
+namespace detail::binary {
+  inline constexpr std::array<char, 8> magic{'C', 'P', 'P', 'C', 'I', 'A', 'G', '\0'};
+  inline constexpr std::uint32_t version{2};
+  // Reads back swapped if the file was written on a machine of the other byte order, which is then rejected
+  inline constexpr std::uint32_t byte_order_mark{0x01020304};
+
+  // Every section starts at an offset aligned to 8 bytes. Numbers are in the byte order of the writing machine, which
+  // must be the one of the reading machine.
+  struct Header {
+   public:
+    // NOLINTBEGIN(*non-private-member*)
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t byte_order;  // `byte_order_mark`
+    std::uint64_t vertex_count;
+    std::uint64_t edge_count;
+    std::uint64_t vertices_offset;    // Vertex_record[vertex_count]
+    std::uint64_t offsets_offset;     // std::uint64_t[vertex_count + 1], as in `Frozen_graph`
+    std::uint64_t targets_offset;     // std::uint32_t[edge_count]
+    std::uint64_t edge_types_offset;  // Edge_type[edge_count]
+    std::uint64_t strings_offset;     // char[strings_size], not null-terminated
+    std::uint64_t strings_size;
+    // NOLINTEND(*non-private-member*)
+  };
+
+  struct String_ref {
+   public:
+    // NOLINTBEGIN(*non-private-member*)
+    std::uint32_t offset;
+    std::uint32_t size;
+    // NOLINTEND(*non-private-member*)
+  };
+
+  struct Range_record {
+   public:
+    // NOLINTBEGIN(*non-private-member*)
+    std::int32_t start_line;
+    std::int32_t start_character;
+    std::int32_t end_line;
+    std::int32_t end_character;
+    // NOLINTEND(*non-private-member*)
+  };
+
+  struct Vertex_record {
+   public:
+    static constexpr std::uint32_t truncated{1U << 0U};
+    static constexpr std::uint32_t has_full_range{1U << 1U};
+
+    // NOLINTBEGIN(*non-private-member*)
+    std::uint32_t kind;
+    std::uint32_t flags;
+    String_ref file;
+    String_ref namespace_scopes;
+    String_ref local_scopes;
+    String_ref name;
+    Range_record name_range;
+    Range_record full_range;
+    std::array<char, clang::clangd::SymbolID::RawSize> symbol_id;
+    // NOLINTEND(*non-private-member*)
+  };
+
+  static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<Vertex_record>);
+}  // namespace detail::binary
+
+// Writes `graph` in the layout read by `Mapped_reference_graph`: a versioned header, fixed-size vertex records, the
+// edges in compressed sparse row layout and a table of the strings the records point into
+void write_binary(std::ostream& ostream, Frozen_reference_graph const& graph);
+
+// A graph file written by `write_binary`, mapped into memory and read in place. Nothing is parsed when it is opened,
+// and only `vertex` copies the strings of a record out of the file.
+class Mapped_reference_graph {
+ public:
+  using Vertex_id = graaf::vertex_id_t;
+
+  // Throws `std::runtime_error` if `file` can't be read, is not a graph of the current version and byte order, or any
+  // of its offsets, ids, strings or kinds is out of range, so that reading it afterwards never goes out of bounds
+  explicit Mapped_reference_graph(llvm::StringRef file);
+
+  [[nodiscard]] auto vertex_count() const -> std::size_t {
+    return vertices_.size();
+  }
+  [[nodiscard]] auto edge_count() const -> std::size_t {
+    return targets_.size();
+  }
+
+  [[nodiscard]] auto vertex(Vertex_id id) const -> Reference;
+  [[nodiscard]] auto targets(Vertex_id id) const -> std::span<std::uint32_t const> {
+    return targets_.subspan(offsets_[id], offsets_[id + 1] - offsets_[id]);
+  }
+  [[nodiscard]] auto edge_types(Vertex_id id) const -> std::span<Edge_type const> {
+    return edge_types_.subspan(offsets_[id], offsets_[id + 1] - offsets_[id]);
+  }
+
+  [[nodiscard]] auto to_frozen() const -> Frozen_reference_graph;
+
+ private:
+  void validate(llvm::StringRef file) const;
+
+  [[nodiscard]] auto string(detail::binary::String_ref ref) const -> std::string_view {
+    return strings_.substr(ref.offset, ref.size);
+  }
+
+  std::unique_ptr<llvm::MemoryBuffer> buffer_;
+  std::span<detail::binary::Vertex_record const> vertices_;
+  std::span<std::uint64_t const> offsets_;
+  std::span<std::uint32_t const> targets_;
+  std::span<Edge_type const> edge_types_;
+  std::string_view strings_;
+};
+
+// Sends every vertex and then every edge of `graph`, in the order of their ids
+void send_to(Graph_sink<Reference, Edge_type>& sink, Mapped_reference_graph const& graph);
+}  // namespace cppcia
+
+#endif
\ No newline at end of file
@@ -0,0 +1,154 @@
+#ifndef CPPCIA_DETAIL_HIERARCHY_HPP
+#define CPPCIA_DETAIL_HIERARCHY_HPP
+
+#include "cppcia/reference.hpp"
+#include "cppcia/referencer.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <clangd/index/SymbolID.h>
+#include <graaflib/types.h>
+#include <llvm/ADT/DenseMap.h>
+
+namespace cppcia {
+namespace detail {
+  // Expands a hierarchy level by level, so that every level costs one batch of requests rather than one per node.
+  // Each symbol is expanded only once, a symbol reached again only gets a new edge, so that shared callers don't
+  // multiply the graph and recursive ones don't loop forever.
+  //
+  // Vertices are added to `output` once they are final, i.e. once their level is expanded or the walk stops, and edges
+  // once both of their ends are added. A sink-backed `output` thus writes a huge hierarchy out while it's walked.
+  template <typename Item>
+  void find_hierarchies(Reference root_reference,
+                        Item root_item,
+                        std::invocable<std::vector<Item> const&> auto find_next_per_item,
+                        std::invocable<std::vector<Item> const&> auto query_references,
+                        Edge_type edge_type,
+                        bool reverse_edge,
+                        Walk_budget& budget,
+                        Reference_graph_builder& output) {
+    // Vertices of the walk are numbered in the order they are reached, and get their ids in `output` once added
+    using Walk_id = std::size_t;
+    std::vector<std::optional<graaf::vertex_id_t>> output_ids;
+
+    // Symbols are told apart by their IDs where they have one, since the root and the symbols reached from it may be
+    // located at different declarations of one symbol
+    std::unordered_map<Reference, Walk_id> visited_references;
+    llvm::DenseMap<clang::clangd::SymbolID, Walk_id> visited_symbols;
+    auto const find_visited{[&](Reference const& reference) -> std::optional<Walk_id> {
+      if (reference.symbol_id) {
+        if (auto iter{visited_symbols.find(reference.symbol_id)}; iter != visited_symbols.end()) {
+          return iter->second;
+        }
+        return std::nullopt;
+      }
+      if (auto iter{visited_references.find(reference)}; iter != visited_references.end()) {
+        return iter->second;
+      }
+      return std::nullopt;
+    }};
+    auto const add_visited{[&](Reference const& reference) {
+      Walk_id const id{output_ids.size()};
+      output_ids.emplace_back();
+      if (reference.symbol_id) {
+        visited_symbols.try_emplace(reference.symbol_id, id);
+      } else {
+        visited_references.try_emplace(reference, id);
+      }
+      return id;
+    }};
+
+    // Edges from parents to children, kept until both ends are added
+    std::vector<std::pair<Walk_id, Walk_id>> pending_edges;
+    std::vector<Walk_id> frontier_ids{add_visited(root_reference)};
+    std::vector<Reference> frontier_references{std::move(root_reference)};
+    std::vector<Item> frontier_items{std::move(root_item)};
+    auto const add_frontier{[&] {
+      for (std::size_t i{0}; i < frontier_ids.size(); ++i) {
+        output_ids[frontier_ids[i]] = output.add_vertex(frontier_references[i]);
+      }
+      std::erase_if(pending_edges, [&](std::pair<Walk_id, Walk_id> const& edge) {
+        auto const parent{output_ids[edge.first]};
+        auto const child{output_ids[edge.second]};
+        if (!parent || !child) {
+          return false;
+        }
+        if (reverse_edge) {
+          output.add_edge(*child, *parent, edge_type);
+        } else {
+          output.add_edge(*parent, *child, edge_type);
+        }
+        return true;
+      });
+    }};
+
+    auto const out_of_budget{[&budget](std::size_t depth) {
+      return budget.out_of_depth(depth) || budget.out_of_vertices() || budget.out_of_time();
+    }};
+
+    for (std::size_t depth{0}; !frontier_items.empty(); ++depth) {
+      if (out_of_budget(depth)) {
+        // The frontier is left unexpanded, some of it may have been leaves anyway
+        for (auto& reference : frontier_references) {
+          reference.truncated = true;
+        }
+        break;
+      }
+
+      std::vector<std::vector<Item>> next_items_per_item{std::invoke(find_next_per_item, frontier_items)};
+
+      std::vector<Item> next_items;
+      for (auto& items : next_items_per_item) {
+        next_items.insert(
+            next_items.end(), std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+      }
+      std::vector<std::optional<Reference>> next_references{std::invoke(query_references, next_items)};
+
+      std::vector<Walk_id> kept_ids;
+      std::vector<Reference> kept_references;
+      std::vector<Item> kept_items;
+      for (std::size_t i{0}, next{0}; i < frontier_ids.size(); ++i) {
+        for (std::size_t j{0}; j < next_items_per_item[i].size(); ++j, ++next) {
+          if (!next_references[next]) {
+            continue;
+          }
+
+          auto id{find_visited(*next_references[next])};
+          if (!id) {
+            if (budget.out_of_vertices()) {
+              frontier_references[i].truncated = true;
+              continue;
+            }
+            budget.take_vertex();
+            id = add_visited(*next_references[next]);
+            kept_ids.push_back(*id);
+            kept_references.push_back(*std::move(next_references[next]));
+            kept_items.push_back(std::move(next_items[next]));
+          }
+          pending_edges.emplace_back(frontier_ids[i], *id);
+        }
+      }
+
+      // A vertex none of whose neighbours was dropped is complete, however other walks that reached it ended
+      for (auto& reference : frontier_references) {
+        reference.expanded = !reference.truncated;
+      }
+      add_frontier();
+
+      frontier_ids        = std::move(kept_ids);
+      frontier_references = std::move(kept_references);
+      frontier_items      = std::move(kept_items);
+    }
+    add_frontier();
+  }
+}  // namespace detail
+}  // namespace cppcia
+
+#endif
\ No newline at end of file
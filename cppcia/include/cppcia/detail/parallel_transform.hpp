@@ -0,0 +1,56 @@
+#ifndef CPPCIA_DETAIL_PARALLEL_TRANSFORM_HPP
+#define CPPCIA_DETAIL_PARALLEL_TRANSFORM_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace cppcia {
+namespace detail {
+  // Invokes `function` on every input, splitting the inputs into `jobs` contiguous chunks transformed concurrently.
+  // The results are in the same order as the inputs.
+  template <typename Input, std::invocable<Input const&> Function>
+  [[nodiscard]] auto parallel_transform(std::span<Input const> inputs, Function const& function, std::size_t jobs)
+      -> std::vector<std::invoke_result_t<Function const&, Input const&>> {
+    using Output = std::invoke_result_t<Function const&, Input const&>;
+
+    auto const transform_chunk{[&function](std::span<Input const> chunk) {
+      std::vector<Output> result;
+      result.reserve(chunk.size());
+      for (auto const& input : chunk) {
+        result.push_back(std::invoke(function, input));
+      }
+      return result;
+    }};
+
+    jobs = std::clamp<std::size_t>(jobs, 1, std::max<std::size_t>(inputs.size(), 1));
+    if (jobs == 1) {
+      return transform_chunk(inputs);
+    }
+
+    std::size_t const chunk_size{(inputs.size() + jobs - 1) / jobs};
+    std::vector<std::future<std::vector<Output>>> chunks;
+    for (std::size_t first{0}; first < inputs.size(); first += chunk_size) {
+      chunks.push_back(std::async(std::launch::async,
+                                  transform_chunk,
+                                  inputs.subspan(first, std::min(chunk_size, inputs.size() - first))));
+    }
+
+    std::vector<Output> result;
+    result.reserve(inputs.size());
+    for (auto& chunk : chunks) {
+      auto outputs{chunk.get()};
+      result.insert(result.end(), std::make_move_iterator(outputs.begin()), std::make_move_iterator(outputs.end()));
+    }
+    return result;
+  }
+}  // namespace detail
+}  // namespace cppcia
+
+#endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef CPPCIA_DIFF_HPP
+#define CPPCIA_DIFF_HPP
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/StringRef.h>
+
+namespace cppcia {
+// Lines [first, last] of a file, counted from 0 as in LSP positions
+struct Line_range {
+ public:
+  [[nodiscard]] friend auto operator==(Line_range const& lhs, Line_range const& rhs) -> bool = default;
+
+  // NOLINTBEGIN(*non-private-member*)
+  int first;
+  int last;
+  // NOLINTEND(*non-private-member*)
+};
+
+// Sorted by their first lines, with overlapping and adjacent ranges merged
+[[nodiscard]] auto merged(std::vector<Line_range> ranges) -> std::vector<Line_range>;
+// Whether any of `ranges`, as returned by `merged`, shares a line with [first, last]
+[[nodiscard]] auto intersects(std::span<Line_range const> ranges, int first, int last) -> bool;
+
+struct File_diff {
+ public:
+  // NOLINTBEGIN(*non-private-member*)
+  std::string file;                       // as written after `+++ `, without the `b/` prefix
+  std::vector<Line_range> changed_lines;  // as returned by `merged`
+  // NOLINTEND(*non-private-member*)
+};
+
+// Lines are those of the new version of each file. Removed lines mark the line where they were removed, so that a
+// pure deletion still touches the symbol it happened in. Deleted files are skipped since they have no new version.
+[[nodiscard]] auto parse_unified_diff(llvm::StringRef diff) -> std::vector<File_diff>;
+}  // namespace cppcia
+
+#endif
\ No newline at end of file
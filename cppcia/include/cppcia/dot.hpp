@@ -1,7 +1,8 @@
 #ifndef CPPCIA_DOT_HPP
 #define CPPCIA_DOT_HPP
 
-#include "cppcia/detail/raw_streamed.hpp"
+#include "cppcia/frozen_graph.hpp"
+#include "cppcia/graph_util.hpp"
 #include "cppcia/reference.hpp"
 
 #include <cstddef>
@@ -13,6 +14,8 @@
 #include <ostream>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
 
 #include <fmt/core.h>
 #include <fmt/ostream.h>
@@ -57,6 +60,45 @@ inline namespace cpo {
   }};
 }  // namespace cpo
 
+// Writes every vertex and edge as soon as it is received, so that neither the graph nor its labels need to be kept
+// in memory. The graph is closed by `finish`.
+template <typename Vertex,
+          typename Edge,
+          typename Vertex_writer_t,
+          typename Edge_writer_t       = decltype(empty_writer),
+          graaf::graph_type Graph_type = graaf::graph_type::DIRECTED>
+  requires std::is_invocable_r_v<std::string, Vertex_writer_t const&, graaf::vertex_id_t, Vertex const&>
+           && std::is_invocable_r_v<std::string, Edge_writer_t const&, graaf::edge_id_t const&, Edge const&>
+class [[nodiscard]] Dot_sink final : public Graph_sink<Vertex, Edge> {
+ public:
+  Dot_sink(std::ostream& ostream, Vertex_writer_t vertex_writer, Edge_writer_t edge_writer = empty_writer)
+      : iter_{ostream}, vertex_writer_{std::move(vertex_writer)}, edge_writer_{std::move(edge_writer)} {
+    iter_ = fmt::format_to(iter_, "{} {{\n", detail::graph_type_to_string(Graph_type));
+  }
+
+  void add_vertex(graaf::vertex_id_t id, Vertex const& vertex) override {
+    iter_ = fmt::format_to(iter_, "  {} [{}];\n", id, std::invoke(vertex_writer_, id, vertex));
+  }
+
+  void add_edge(graaf::vertex_id_t source, graaf::vertex_id_t target, Edge const& edge) override {
+    iter_ = fmt::format_to(iter_,
+                           "  {} {} {} [{}];\n",
+                           source,
+                           detail::graph_type_to_edge_specifier(Graph_type),
+                           target,
+                           std::invoke(edge_writer_, graaf::edge_id_t{source, target}, edge));
+  }
+
+  void finish() {
+    iter_ = fmt::format_to(iter_, "}}\n");
+  }
+
+ private:
+  std::ostreambuf_iterator<char> iter_;
+  Vertex_writer_t vertex_writer_;
+  Edge_writer_t edge_writer_;
+};
+
 template <typename Vertex,
           typename Edge,
           graaf::graph_type Graph_type,
@@ -71,22 +113,31 @@ void format_to_in_dot(std::ostream& ostream,
                       graaf::graph<Vertex, Edge, Graph_type> const& graph,
                       Vertex_writer_t vertex_writer,
                       Edge_writer_t edge_writer = empty_writer) {
-  std::ostreambuf_iterator<char> iter{ostream};
-
-  iter = fmt::format_to(iter, "{} {{\n", detail::graph_type_to_string(Graph_type));
-
+  Dot_sink<Vertex, Edge, Vertex_writer_t, Edge_writer_t, Graph_type> sink{
+      ostream, std::move(vertex_writer), std::move(edge_writer)};
   for (auto const& [vertex_id, vertex] : graph.get_vertices()) {
-    iter = fmt::format_to(iter, "  {} [{}];\n", vertex_id, std::invoke(vertex_writer, vertex_id, vertex));
+    sink.add_vertex(vertex_id, vertex);
   }
-
-  auto const edge_specifier{detail::graph_type_to_edge_specifier(Graph_type)};
   for (auto const& [edge_id, edge] : graph.get_edges()) {
-    auto const [source_id, target_id]{edge_id};
-    iter = fmt::format_to(
-        iter, "  {} {} {} [{}];\n", source_id, edge_specifier, target_id, std::invoke(edge_writer, edge_id, edge));
+    sink.add_edge(edge_id.first, edge_id.second, edge);
   }
+  sink.finish();
+}
 
-  iter = fmt::format_to(iter, "}}\n");
+template <typename Vertex,
+          typename Edge,
+          typename Vertex_writer_t,
+          typename Edge_writer_t = decltype(empty_writer)>
+  requires std::is_invocable_r_v<std::string, Vertex_writer_t const&, graaf::vertex_id_t, Vertex const&>
+           && std::is_invocable_r_v<std::string, Edge_writer_t const&, graaf::edge_id_t const&, Edge const&>
+void format_to_in_dot(std::ostream& ostream,
+                      Frozen_graph<Vertex, Edge> const& graph,
+                      Vertex_writer_t vertex_writer,
+                      Edge_writer_t edge_writer = empty_writer) {
+  Dot_sink<Vertex, Edge, Vertex_writer_t, Edge_writer_t> sink{
+      ostream, std::move(vertex_writer), std::move(edge_writer)};
+  send_to(sink, graph);
+  sink.finish();
 }
 
 namespace detail {
@@ -117,59 +168,105 @@ namespace detail {
     }
     return result;
   }
+
+  // Same as streaming `range` into a `llvm::raw_ostream`, without the temporary string
+  template <std::output_iterator<char> Iterator>
+  auto format_range_to(Iterator iter, Range const& range) -> Iterator {
+    return fmt::format_to(
+        iter, "{}:{}-{}:{}", range.start.line, range.start.character, range.end.line, range.end.character);
+  }
 }  // namespace detail
 
+// Many vertices share their files and scopes, so relative paths and escaped strings are cached, and every label is
+// formatted into the same buffer. A writer is thus not thread-safe, and a label is only valid until the next one.
 class [[nodiscard]] Reference_writer {
  public:
-  [[nodiscard]] auto operator()(graaf::vertex_id_t /*id*/, Reference const& reference) const -> std::string {
-    std::string result{};
+  // Paths are relative to `workspace_root`, or to the current path if not specified
+  explicit Reference_writer(std::optional<std::filesystem::path> workspace_root = std::nullopt)
+      : workspace_root_{workspace_root ? std::move(*workspace_root) : std::filesystem::current_path()} {}
+
+  [[nodiscard]] auto operator()(graaf::vertex_id_t /*id*/, Reference const& reference) const -> std::string const& {
+    buffer_.clear();
+    auto iter{std::back_inserter(buffer_)};
 
     // clang-format off
-    result += "label=<\n"
-              "    <TABLE BORDER = \"0\" CELLBORDER = \"1\" CELLSPACING = \"0\">\n";
+    iter = fmt::format_to(iter,
+                          "label=<\n"
+                          "    <TABLE BORDER = \"0\" CELLBORDER = \"1\" CELLSPACING = \"0\">\n"
+                          "      <TR>\n"
+                          "        <TD COLSPAN=\"6\">{}</TD>\n"
+                          "      </TR>\n",
+                          magic_enum::enum_name(reference.kind));
     // clang-format on
 
-    result += fmt::format(
-        "      <TR>\n"
-        "        <TD COLSPAN=\"6\">{}</TD>\n"
-        "      </TR>\n",
-        magic_enum::enum_name(reference.kind));
-
     if (reference.kind != SymbolKind::File) {
-      result += fmt::format(
+      iter = fmt::format_to(
+          iter,
           "      <TR>\n"
           "        <TD COLSPAN=\"2\">{}</TD><TD COLSPAN=\"2\">{}</TD><TD COLSPAN=\"2\">{}</TD>\n"
           "      </TR>\n",
-          reference.namespace_scopes,
-          detail::html_escaped(reference.local_scopes),
-          detail::html_escaped(reference.name));
+          reference.namespace_scopes.view(),
+          escaped(reference.local_scopes),
+          escaped(reference.name));
     }
 
-    result += fmt::format(
-        "      <TR>\n"
-        "        <TD COLSPAN=\"6\">{}</TD>\n"
-        "      </TR>\n",
-        detail::html_escaped(std::filesystem::relative(reference.uri.file().data(),
-                                                       workspace_root.value_or(std::filesystem::current_path()))
-                                 .string()));
+    iter = fmt::format_to(iter,
+                          "      <TR>\n"
+                          "        <TD COLSPAN=\"6\">{}</TD>\n"
+                          "      </TR>\n",
+                          relative_file(reference.uri));
 
     if (reference.kind != SymbolKind::File) {
-      result += fmt::format(
-          "      <TR>\n"
-          "        <TD COLSPAN=\"3\">{}</TD><TD COLSPAN=\"3\">{}</TD>\n"
-          "      </TR>\n",
-          detail::raw_streamed(reference.name_range),
-          reference.full_range ? detail::raw_streamed(reference.full_range) : "");
+      iter = fmt::format_to(iter,
+                            "      <TR>\n"
+                            "        <TD COLSPAN=\"3\">");
+      iter = detail::format_range_to(iter, reference.name_range);
+      iter = fmt::format_to(iter, "</TD><TD COLSPAN=\"3\">");
+      if (reference.full_range) {
+        iter = detail::format_range_to(iter, *reference.full_range);
+      }
+      iter = fmt::format_to(iter,
+                            "</TD>\n"
+                            "      </TR>\n");
+    }
+
+    if (reference.truncated) {
+      iter = fmt::format_to(iter,
+                            "      <TR>\n"
+                            "        <TD COLSPAN=\"6\" BGCOLOR=\"lightgrey\">truncated</TD>\n"
+                            "      </TR>\n");
     }
 
     // clang-format off
-    result += "    </TABLE>>,\n"
-              "    shape=none";
+    iter = fmt::format_to(iter,
+                          "    </TABLE>>,\n"
+                          "    shape=none");
     // clang-format on
-    return result;
+    return buffer_;
+  }
+
+ private:
+  [[nodiscard]] auto escaped(Interned_string string) const -> std::string const& {
+    auto [iter, inserted]{escaped_strings_.try_emplace(string)};
+    if (inserted) {
+      iter->second = detail::html_escaped(string);
+    }
+    return iter->second;
+  }
+
+  // Computing a relative path queries the filesystem
+  [[nodiscard]] auto relative_file(Interned_uri uri) const -> std::string const& {
+    auto [iter, inserted]{relative_files_.try_emplace(uri)};
+    if (inserted) {
+      iter->second = detail::html_escaped(std::filesystem::relative(uri.file().data(), workspace_root_).string());
+    }
+    return iter->second;
   }
 
-  std::optional<std::filesystem::path> workspace_root;  // NOLINT(*non-private-member*)
+  std::filesystem::path workspace_root_;
+  mutable std::unordered_map<Interned_string, std::string> escaped_strings_;
+  mutable std::unordered_map<Interned_uri, std::string> relative_files_;
+  mutable std::string buffer_;
 };
 }  // namespace cppcia
 
@@ -1,36 +1,60 @@
 #ifndef CPPCIA_EXTRACTOR_HPP
 #define CPPCIA_EXTRACTOR_HPP
 
+#include <filesystem>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <clangd/ClangdServer.h>
 #include <clangd/GlobalCompilationDatabase.h>
 #include <clangd/Hover.h>
 #include <clangd/Protocol.h>
+#include <clangd/SourceCode.h>
 #include <clangd/XRefs.h>
 #include <clangd/index/Index.h>
+#include <clangd/index/Relation.h>
+#include <clangd/index/Symbol.h>
+#include <clangd/index/SymbolID.h>
 #include <clangd/support/Path.h>
 #include <clangd/support/ThreadsafeFS.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringMap.h>
 #include <llvm/ADT/StringRef.h>
 
 namespace cppcia {
+using File_position = std::pair<std::string, clang::clangd::Position>;
+// Direct bases of each class. The index records `RelationKind::BaseOf` from bases to derived classes only, so this is
+// read from its relations once when it's loaded.
+using Base_map = llvm::DenseMap<clang::clangd::SymbolID, std::vector<clang::clangd::SymbolID>>;
+
+[[nodiscard]] auto make_base_map(clang::clangd::RelationSlab const& relations) -> Base_map;
+
 class Extractor {
  public:
   Extractor(std::unique_ptr<clang::clangd::GlobalCompilationDatabase> cdb,
             std::unique_ptr<clang::clangd::ThreadsafeFS> tfs,
             clang::clangd::ClangdServer::Options options,
-            std::unique_ptr<clang::clangd::SymbolIndex> symbol_index = nullptr);
+            std::unique_ptr<clang::clangd::SymbolIndex> symbol_index = nullptr,
+            Base_map bases                                           = {});
 
-  void update_file(clang::clangd::PathRef file, llvm::StringRef content);
+  // Returns false without touching clangd if the content is the same as the last update of the file. The content
+  // replaces the one on disk until the file is modified there.
+  auto update_file(clang::clangd::PathRef file, llvm::StringRef content) -> bool;
+  // Same as above, but reads the file from disk unless its modification time hasn't changed since the last read
+  auto update_file(clang::clangd::PathRef file) -> bool;
 
   [[nodiscard]] auto query_file(llvm::StringRef file) -> std::vector<clang::clangd::DocumentSymbol>;
   [[nodiscard]] auto query_location_pos(clang::clangd::PathRef file,
                                         clang::clangd::Position pos) -> std::vector<clang::clangd::LocatedSymbol>;
   [[nodiscard]] auto query_location_info(clang::clangd::PathRef file,
                                          clang::clangd::Position pos) -> std::optional<clang::clangd::HoverInfo>;
+  // Sends all hover requests at once and waits for them together, the results are in the same order as `positions`
+  [[nodiscard]] auto query_location_infos(std::vector<File_position> const& positions)
+      -> std::vector<std::optional<clang::clangd::HoverInfo>>;
   [[nodiscard]] auto query_name(llvm::StringRef name,
                                 bool fuzzy = false) -> std::vector<clang::clangd::SymbolInformation>;
 
@@ -38,29 +62,76 @@ class Extractor {
                                clang::clangd::Position pos) -> std::vector<clang::clangd::LocatedSymbol>;
   [[nodiscard]] auto find_references(clang::clangd::PathRef file,
                                      clang::clangd::Position pos) -> clang::clangd::ReferencesResult;
+  // Reads references from the static index only, no AST is built
+  [[nodiscard]] auto find_index_references(clang::clangd::SymbolID const& id) -> std::vector<clang::clangd::Location>;
+
+  [[nodiscard]] auto lookup_index_symbols(std::vector<clang::clangd::SymbolID> const& ids)
+      -> std::vector<clang::clangd::Symbol>;
+  [[nodiscard]] auto query_index_name(llvm::StringRef scope,
+                                      llvm::StringRef name) -> std::vector<clang::clangd::Symbol>;
+  // Containers of the references to each symbol, i.e. the callers of each function, read from the static index only
+  [[nodiscard]] auto find_index_callers_per_id(std::vector<clang::clangd::SymbolID> const& ids)
+      -> std::vector<std::vector<clang::clangd::Symbol>>;
+  // Derived classes of each class through `RelationKind::BaseOf`, read from the static index only
+  [[nodiscard]] auto find_index_subtypes_per_id(std::vector<clang::clangd::SymbolID> const& ids)
+      -> std::vector<std::vector<clang::clangd::Symbol>>;
+  // Direct bases of each class from the base map, read from the static index only
+  [[nodiscard]] auto find_index_supertypes_per_id(std::vector<clang::clangd::SymbolID> const& ids)
+      -> std::vector<std::vector<clang::clangd::Symbol>>;
 
   [[nodiscard]] auto prepare_call_hierarchy(clang::clangd::PathRef file, clang::clangd::Position pos)
       -> std::vector<clang::clangd::CallHierarchyItem>;
   [[nodiscard]] auto find_callers(std::vector<clang::clangd::CallHierarchyItem> const& items)
       -> std::vector<clang::clangd::CallHierarchyIncomingCall>;
+  [[nodiscard]] auto find_callers_per_item(std::vector<clang::clangd::CallHierarchyItem> const& items)
+      -> std::vector<std::vector<clang::clangd::CallHierarchyIncomingCall>>;
 
   [[nodiscard]] auto prepare_type_hierarchy(clang::clangd::PathRef file, clang::clangd::Position pos)
       -> std::vector<clang::clangd::TypeHierarchyItem>;
   [[nodiscard]] auto find_supertypes(std::vector<clang::clangd::TypeHierarchyItem> const& items)
       -> std::vector<clang::clangd::TypeHierarchyItem>;
+  [[nodiscard]] auto find_supertypes_per_item(std::vector<clang::clangd::TypeHierarchyItem> const& items)
+      -> std::vector<std::vector<clang::clangd::TypeHierarchyItem>>;
   [[nodiscard]] auto find_subtypes(std::vector<clang::clangd::TypeHierarchyItem> const& items)
       -> std::vector<clang::clangd::TypeHierarchyItem>;
+  [[nodiscard]] auto find_subtypes_per_item(std::vector<clang::clangd::TypeHierarchyItem> const& items)
+      -> std::vector<std::vector<clang::clangd::TypeHierarchyItem>>;
 
  private:
+  struct Document {
+   public:
+    // NOLINTBEGIN(*non-private-member*)
+    clang::clangd::FileDigest digest;
+    std::optional<std::filesystem::file_time_type> modification_time;
+    // NOLINTEND(*non-private-member*)
+  };
+
+  auto update_file(clang::clangd::PathRef file,
+                   llvm::StringRef content,
+                   std::optional<std::filesystem::file_time_type> modification_time) -> bool;
+
+  // Guards `documents_` and submissions to `server_`, which may be shared by several threads querying concurrently
+  std::unique_ptr<std::mutex> mutex_{std::make_unique<std::mutex>()};
+  llvm::StringMap<Document> documents_;
   std::unique_ptr<clang::clangd::GlobalCompilationDatabase> cdb_;
   std::unique_ptr<clang::clangd::ThreadsafeFS> tfs_;
   std::unique_ptr<clang::clangd::SymbolIndex> symbol_index_;
+  Base_map bases_;
   std::unique_ptr<clang::clangd::ClangdServer> server_;
 };
 
 [[nodiscard]] auto read_file(clang::clangd::PathRef file) -> std::string;
 
-[[nodiscard]] auto load_index(clang::clangd::PathRef index_file) -> std::unique_ptr<clang::clangd::SymbolIndex>;
+struct Static_index {
+ public:
+  // NOLINTBEGIN(*non-private-member*)
+  std::unique_ptr<clang::clangd::SymbolIndex> symbol_index;
+  Base_map bases;
+  // NOLINTEND(*non-private-member*)
+};
+
+// An empty index is returned if `index_file` can't be read, so that queries still work from parsed files
+[[nodiscard]] auto load_index(clang::clangd::PathRef index_file) -> Static_index;
 
 [[nodiscard]] auto make_extractor(clang::clangd::PathRef index_file,
                                   clang::clangd::PathRef compile_commands_dir,
@@ -0,0 +1,199 @@
+#ifndef CPPCIA_FROZEN_GRAPH_HPP
+#define CPPCIA_FROZEN_GRAPH_HPP
+
+#include "cppcia/detail/parallel_transform.hpp"
+#include "cppcia/graph_util.hpp"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <graaflib/graph.h>
+#include <graaflib/types.h>
+#include <range/v3/all.hpp>
+
+namespace cppcia {
+// An immutable directed graph in compressed sparse row layout. Vertices are numbered densely from 0, and the out edges
+// of vertex `id` are [offsets[id], offsets[id + 1]) of the contiguous target and edge arrays. Meant for graphs that are
+// only read once built, where iterating arrays beats the node-based maps inside graaf.
+template <typename Vertex, typename Edge>
+class Frozen_graph {
+ public:
+  using Vertex_id = graaf::vertex_id_t;
+
+  struct Edge_entry {
+   public:
+    // NOLINTBEGIN(*non-private-member*)
+    Vertex_id source;
+    Vertex_id target;
+    Edge edge;
+    // NOLINTEND(*non-private-member*)
+  };
+
+  Frozen_graph() = default;
+
+  // Edges between the same pair of vertices are merged, keeping the first one
+  Frozen_graph(std::vector<Vertex> vertices, std::vector<Edge_entry> edges) : vertices_{std::move(vertices)} {
+    auto const endpoints{[](Edge_entry const& entry) { return std::pair{entry.source, entry.target}; }};
+    ranges::stable_sort(edges, std::less{}, endpoints);
+    edges.erase(std::unique(edges.begin(),
+                            edges.end(),
+                            [&endpoints](Edge_entry const& lhs, Edge_entry const& rhs) {
+                              return endpoints(lhs) == endpoints(rhs);
+                            }),
+                edges.end());
+
+    offsets_.assign(vertices_.size() + 1, 0);
+    targets_.reserve(edges.size());
+    edges_.reserve(edges.size());
+    for (auto& entry : edges) {
+      ++offsets_[entry.source + 1];
+      targets_.push_back(entry.target);
+      edges_.push_back(std::move(entry.edge));
+    }
+    for (std::size_t id{0}; id < vertices_.size(); ++id) {
+      offsets_[id + 1] += offsets_[id];
+    }
+  }
+
+  [[nodiscard]] auto vertex_count() const -> std::size_t {
+    return vertices_.size();
+  }
+  [[nodiscard]] auto edge_count() const -> std::size_t {
+    return targets_.size();
+  }
+
+  [[nodiscard]] auto vertices() const -> std::span<Vertex const> {
+    return vertices_;
+  }
+  [[nodiscard]] auto vertex(Vertex_id id) const -> Vertex const& {
+    return vertices_[id];
+  }
+
+  [[nodiscard]] auto targets(Vertex_id id) const -> std::span<Vertex_id const> {
+    return std::span<Vertex_id const>{targets_}.subspan(offsets_[id], offsets_[id + 1] - offsets_[id]);
+  }
+  [[nodiscard]] auto edges(Vertex_id id) const -> std::span<Edge const> {
+    return std::span<Edge const>{edges_}.subspan(offsets_[id], offsets_[id + 1] - offsets_[id]);
+  }
+
+  void for_each_edge(std::invocable<Vertex_id, Vertex_id, Edge const&> auto&& function) const {
+    for (Vertex_id source{0}; source < vertices_.size(); ++source) {
+      for (std::size_t i{offsets_[source]}; i < offsets_[source + 1]; ++i) {
+        std::invoke(function, source, targets_[i], edges_[i]);
+      }
+    }
+  }
+
+ private:
+  std::vector<Vertex> vertices_;
+  std::vector<std::size_t> offsets_{0};
+  std::vector<Vertex_id> targets_;
+  std::vector<Edge> edges_;
+};
+
+// Vertices are numbered in the order of their ids in `graph`
+template <typename Vertex, typename Edge>
+[[nodiscard]] auto freeze(graaf::graph<Vertex, Edge, graaf::graph_type::DIRECTED> const& graph)
+    -> Frozen_graph<Vertex, Edge> {
+  using Result = Frozen_graph<Vertex, Edge>;
+
+  std::vector<graaf::vertex_id_t> ids;
+  ids.reserve(graph.vertex_count());
+  for (auto const& [id, _] : graph.get_vertices()) {
+    ids.push_back(id);
+  }
+  ranges::sort(ids);
+
+  std::unordered_map<graaf::vertex_id_t, typename Result::Vertex_id> ids_to_frozen_ids;
+  ids_to_frozen_ids.reserve(ids.size());
+  std::vector<Vertex> vertices;
+  vertices.reserve(ids.size());
+  for (auto id : ids) {
+    ids_to_frozen_ids.try_emplace(id, vertices.size());
+    vertices.push_back(graph.get_vertex(id));
+  }
+
+  std::vector<typename Result::Edge_entry> edges;
+  edges.reserve(graph.edge_count());
+  for (auto const& [uv, edge] : graph.get_edges()) {
+    edges.push_back(typename Result::Edge_entry{
+        .source{ids_to_frozen_ids.at(uv.first)}, .target{ids_to_frozen_ids.at(uv.second)}, .edge{edge}});
+  }
+
+  return Result{std::move(vertices), std::move(edges)};
+}
+
+// Sends every vertex and then every edge of `graph`, in the order of their ids
+template <typename Vertex, typename Edge>
+void send_to(Graph_sink<Vertex, Edge>& sink, Frozen_graph<Vertex, Edge> const& graph) {
+  for (graaf::vertex_id_t id{0}; id < graph.vertex_count(); ++id) {
+    sink.add_vertex(id, graph.vertex(id));
+  }
+  graph.for_each_edge([&sink](graaf::vertex_id_t source, graaf::vertex_id_t target, Edge const& edge) {
+    sink.add_edge(source, target, edge);
+  });
+}
+
+namespace detail {
+  // `mapped_vertices[id]` is the mapped vertex of `id`
+  template <typename Vertex, typename Edge, typename Mapped_vertex>
+  [[nodiscard]] auto map_with(Frozen_graph<Vertex, Edge> const& graph, std::vector<Mapped_vertex> mapped_vertices)
+      -> Frozen_graph<Mapped_vertex, Edge> {
+    using Result = Frozen_graph<Mapped_vertex, Edge>;
+
+    std::vector<typename Result::Vertex_id> old_to_new_ids;
+    old_to_new_ids.reserve(graph.vertex_count());
+    std::unordered_map<Mapped_vertex, typename Result::Vertex_id> mapped_vertices_to_ids;
+    std::vector<Mapped_vertex> unique_vertices;
+    for (auto& mapped_vertex : mapped_vertices) {
+      auto [iter, inserted]{mapped_vertices_to_ids.try_emplace(mapped_vertex, unique_vertices.size())};
+      if (inserted) {
+        unique_vertices.push_back(std::move(mapped_vertex));
+      } else {
+        Vertex_traits<Mapped_vertex>::collapse(unique_vertices[iter->second], mapped_vertex);
+      }
+      old_to_new_ids.push_back(iter->second);
+    }
+
+    std::vector<typename Result::Edge_entry> edges;
+    graph.for_each_edge([&](auto source, auto target, Edge const& edge) {
+      if (old_to_new_ids[source] != old_to_new_ids[target]) {
+        edges.push_back(typename Result::Edge_entry{
+            .source{old_to_new_ids[source]}, .target{old_to_new_ids[target]}, .edge{edge}});
+      }
+    });
+
+    return Result{std::move(unique_vertices), std::move(edges)};
+  }
+}  // namespace detail
+
+// Vertices mapped to the same value are merged by `Vertex_traits::collapse`, and so are the edges between them, while
+// edges within one merged vertex are dropped. The mapper is invoked once per vertex.
+template <typename Vertex, typename Edge, std::invocable<Vertex> Mapper>
+[[nodiscard]] auto map(Frozen_graph<Vertex, Edge> const& graph,
+                       Mapper&& mapper)  // NOLINT(*forward*)
+    -> Frozen_graph<std::invoke_result_t<Mapper, Vertex>, Edge> {
+  std::vector<std::invoke_result_t<Mapper, Vertex>> mapped_vertices;
+  mapped_vertices.reserve(graph.vertex_count());
+  for (auto const& vertex : graph.vertices()) {
+    mapped_vertices.push_back(std::invoke(mapper, vertex));
+  }
+  return detail::map_with(graph, std::move(mapped_vertices));
+}
+
+// Same as `map`, but the mapper is invoked concurrently by `jobs` threads, so it must be thread-safe
+template <typename Vertex, typename Edge, std::invocable<Vertex> Mapper>
+[[nodiscard]] auto parallel_map(Frozen_graph<Vertex, Edge> const& graph, Mapper const& mapper, std::size_t jobs)
+    -> Frozen_graph<std::invoke_result_t<Mapper, Vertex>, Edge> {
+  return detail::map_with(graph, detail::parallel_transform(graph.vertices(), mapper, jobs));
+}
+}  // namespace cppcia
+
+#endif
\ No newline at end of file
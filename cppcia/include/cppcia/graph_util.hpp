@@ -1,17 +1,140 @@
 #ifndef CPPCIA_GRAPH_UTIL_HPP
 #define CPPCIA_GRAPH_UTIL_HPP
 
+#include "cppcia/detail/hash_value.hpp"
+#include "cppcia/detail/parallel_transform.hpp"
+
+#include <algorithm>
 #include <concepts>
+#include <cstddef>
 #include <functional>
+#include <span>
 #include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <graaflib/graph.h>
 #include <graaflib/types.h>
 #include <range/v3/all.hpp>
 
 namespace cppcia {
+// Receives the vertices and edges of a graph one by one, e.g. to write them out before the whole graph is known.
+// Every vertex is received before the edges from or to it.
+template <typename Vertex, typename Edge>
+class Graph_sink {
+ public:
+  Graph_sink()                                     = default;
+  Graph_sink(Graph_sink const&)                    = default;
+  Graph_sink(Graph_sink&&)                         = default;
+  auto operator=(Graph_sink const&) -> Graph_sink& = default;
+  auto operator=(Graph_sink&&) -> Graph_sink&      = default;
+  virtual ~Graph_sink()                            = default;
+
+  virtual void add_vertex(graaf::vertex_id_t id, Vertex const& vertex)                          = 0;
+  virtual void add_edge(graaf::vertex_id_t source, graaf::vertex_id_t target, Edge const& edge) = 0;
+};
+
+// How vertices equal to each other are combined, for vertices that carry state besides what identifies them. Copies of
+// one vertex are combined when graphs are merged, and distinct vertices when a mapping collapses them into one. Both
+// keep the vertex met first unless specialized.
+template <typename Vertex>
+struct Vertex_traits {
+ public:
+  static void merge_copy(Vertex& /*kept*/, Vertex const& /*copy*/) {}
+  static void collapse(Vertex& /*kept*/, Vertex const& /*collapsed*/) {}
+};
+
+namespace detail {
+  class [[nodiscard]] Edge_id_hash {
+   public:
+    [[nodiscard]] auto operator()(graaf::edge_id_t const& edge_id) const -> std::size_t {
+      return hash_value(edge_id.first, edge_id.second);
+    }
+  };
+}  // namespace detail
+
+// Keeps the index from vertices to their ids alive across merges, so that a merge costs as much as the merged graph
+// rather than the whole result as `merge_by` does
+template <typename Vertex, typename Edge, graaf::graph_type Graph_type>
+class Graph_builder {
+ public:
+  using Graph = graaf::graph<Vertex, Edge, Graph_type>;
+
+  Graph_builder() = default;
+  explicit Graph_builder(Graph graph) : graph_{std::move(graph)} {
+    for (auto const& [id, vertex] : graph_.get_vertices()) {
+      vertices_to_ids_.try_emplace(vertex, id);
+    }
+  }
+
+  // Passes every new vertex and edge on to `sink` instead of keeping them, only what tells duplicates apart is kept.
+  // The built graph is then empty, and a vertex is passed on as its first copy is since it can't be combined later.
+  explicit Graph_builder(Graph_sink<Vertex, Edge>& sink) : sink_{&sink} {}
+
+  // A vertex added again is combined into the kept one by `Vertex_traits::merge_copy`
+  auto add_vertex(Vertex const& vertex) -> graaf::vertex_id_t {
+    auto iter{vertices_to_ids_.find(vertex)};
+    if (iter == vertices_to_ids_.end()) {
+      if (sink_ == nullptr) {
+        iter = vertices_to_ids_.try_emplace(vertex, graph_.add_vertex(vertex)).first;
+      } else {
+        iter = vertices_to_ids_.try_emplace(vertex, vertices_to_ids_.size()).first;
+        sink_->add_vertex(iter->second, vertex);
+      }
+    } else if (sink_ == nullptr) {
+      Vertex_traits<Vertex>::merge_copy(graph_.get_vertex(iter->second), vertex);
+    }
+    return iter->second;
+  }
+
+  // Keeps the existing edge if the vertices are already connected
+  void add_edge(graaf::vertex_id_t lhs, graaf::vertex_id_t rhs, Edge const& edge) {
+    if (sink_ == nullptr) {
+      if (!graph_.has_edge(lhs, rhs)) {
+        graph_.add_edge(lhs, rhs, edge);
+      }
+      return;
+    }
+
+    graaf::edge_id_t edge_id{lhs, rhs};
+    if constexpr (Graph_type == graaf::graph_type::UNDIRECTED) {
+      edge_id = std::minmax(lhs, rhs);
+    }
+    if (sunk_edges_.insert(edge_id).second) {
+      sink_->add_edge(lhs, rhs, edge);
+    }
+  }
+
+  auto merge(Graph const& other) -> Graph_builder& {
+    std::unordered_map<graaf::vertex_id_t, graaf::vertex_id_t> other_to_ids;
+    other_to_ids.reserve(other.vertex_count());
+    for (auto const& [other_id, vertex] : other.get_vertices()) {
+      other_to_ids.try_emplace(other_id, add_vertex(vertex));
+    }
+
+    for (auto const& [uv, edge] : other.get_edges()) {
+      add_edge(other_to_ids[uv.first], other_to_ids[uv.second], edge);
+    }
+    return *this;
+  }
+
+  [[nodiscard]] auto graph() const -> Graph const& {
+    return graph_;
+  }
+
+  [[nodiscard]] auto build() && -> Graph {
+    return std::move(graph_);
+  }
+
+ private:
+  Graph graph_;
+  std::unordered_map<Vertex, graaf::vertex_id_t> vertices_to_ids_;
+  Graph_sink<Vertex, Edge>* sink_{nullptr};
+  std::unordered_set<graaf::edge_id_t, detail::Edge_id_hash> sunk_edges_;
+};
+
 template <typename Vertex, typename Edge, graaf::graph_type Graph_type>
 auto merge_by(graaf::graph<Vertex, Edge, Graph_type>& self,
               graaf::graph<Vertex, Edge, Graph_type> const& other) -> graaf::graph<Vertex, Edge, Graph_type>& {
@@ -21,7 +144,9 @@ auto merge_by(graaf::graph<Vertex, Edge, Graph_type>& self,
       | ranges::to<std::unordered_map>()};
 
   for (auto [_, vertex] : other.get_vertices()) {
-    if (!vertices_to_ids.contains(vertex)) {
+    if (auto iter{vertices_to_ids.find(vertex)}; iter != vertices_to_ids.end()) {
+      Vertex_traits<Vertex>::merge_copy(self.get_vertex(iter->second), vertex);
+    } else {
       auto id{self.add_vertex(vertex)};
       vertices_to_ids.try_emplace(vertex, id);
     }
@@ -70,32 +195,79 @@ template <typename Vertex, typename Edge, graaf::graph_type Graph_type>
   return result;
 }
 
-template <typename Vertex, typename Edge, graaf::graph_type Graph_type, std::invocable<Vertex> Mapper>
-[[nodiscard]] auto map(graaf::graph<Vertex, Edge, Graph_type> const& graph,
-                       Mapper&& mapper)  // NOLINT(*forward*)
-    -> graaf::graph<std::invoke_result_t<Mapper, Vertex>, Edge, Graph_type> {
-  using Mapped_vertex = std::invoke_result_t<Mapper, Vertex>;
-  graaf::graph<Mapped_vertex, Edge, Graph_type> result;
-
-  std::unordered_map<Mapped_vertex, graaf::vertex_id_t> mapped_vertices_to_ids{};
-  for (auto [_, vertex] : graph.get_vertices()) {
-    auto mapped_vertex{std::invoke(mapper, vertex)};
-    auto iter{mapped_vertices_to_ids.find(mapped_vertex)};
-    if (iter == mapped_vertices_to_ids.end()) {
-      auto id{result.add_vertex(mapped_vertex)};
-      mapped_vertices_to_ids.emplace_hint(iter, std::move(mapped_vertex), id);
+namespace detail {
+  template <typename Vertex, typename Edge, graaf::graph_type Graph_type>
+  [[nodiscard]] auto sorted_vertex_ids(graaf::graph<Vertex, Edge, Graph_type> const& graph)
+      -> std::vector<graaf::vertex_id_t> {
+    std::vector<graaf::vertex_id_t> result;
+    result.reserve(graph.vertex_count());
+    for (auto const& [id, _] : graph.get_vertices()) {
+      result.push_back(id);
     }
+    ranges::sort(result);
+    return result;
   }
 
-  for (auto [uv, edge] : graph.get_edges()) {
-    auto u_mapped_id{mapped_vertices_to_ids[std::invoke(mapper, graph.get_vertex(uv.first))]};
-    auto v_mapped_id{mapped_vertices_to_ids[std::invoke(mapper, graph.get_vertex(uv.second))]};
-    if (u_mapped_id != v_mapped_id) {
-      result.add_edge(u_mapped_id, v_mapped_id, edge);
+  // `mapped_vertices[i]` is the mapped vertex of `ids[i]`, where `ids` are sorted
+  template <typename Vertex, typename Edge, graaf::graph_type Graph_type, typename Mapped_vertex>
+  [[nodiscard]] auto map_with(graaf::graph<Vertex, Edge, Graph_type> const& graph,
+                              std::vector<graaf::vertex_id_t> const& ids,
+                              std::vector<Mapped_vertex> mapped_vertices)
+      -> graaf::graph<Mapped_vertex, Edge, Graph_type> {
+    graaf::graph<Mapped_vertex, Edge, Graph_type> result;
+
+    std::vector<graaf::vertex_id_t> old_to_new_ids(ids.empty() ? 0 : ids.back() + 1);
+    std::unordered_map<Mapped_vertex, graaf::vertex_id_t> mapped_vertices_to_ids{};
+    for (std::size_t i{0}; i < ids.size(); ++i) {
+      auto iter{mapped_vertices_to_ids.find(mapped_vertices[i])};
+      if (iter == mapped_vertices_to_ids.end()) {
+        auto id{result.add_vertex(mapped_vertices[i])};
+        iter = mapped_vertices_to_ids.emplace_hint(iter, std::move(mapped_vertices[i]), id);
+      } else {
+        Vertex_traits<Mapped_vertex>::collapse(result.get_vertex(iter->second), mapped_vertices[i]);
+      }
+      old_to_new_ids[ids[i]] = iter->second;
+    }
+
+    for (auto const& [uv, edge] : graph.get_edges()) {
+      auto u_mapped_id{old_to_new_ids[uv.first]};
+      auto v_mapped_id{old_to_new_ids[uv.second]};
+      if (u_mapped_id != v_mapped_id && !result.has_edge(u_mapped_id, v_mapped_id)) {
+        result.add_edge(u_mapped_id, v_mapped_id, edge);
+      }
     }
+
+    return result;
   }
+}  // namespace detail
 
-  return result;
+// Vertices mapped to the same value are merged by `Vertex_traits::collapse`, and so are the edges between them, while
+// edges within one merged vertex are dropped. The mapper is invoked once per vertex.
+template <typename Vertex, typename Edge, graaf::graph_type Graph_type, std::invocable<Vertex> Mapper>
+[[nodiscard]] auto map(graaf::graph<Vertex, Edge, Graph_type> const& graph,
+                       Mapper&& mapper)  // NOLINT(*forward*)
+    -> graaf::graph<std::invoke_result_t<Mapper, Vertex>, Edge, Graph_type> {
+  std::vector<graaf::vertex_id_t> ids{detail::sorted_vertex_ids(graph)};
+  std::vector<std::invoke_result_t<Mapper, Vertex>> mapped_vertices;
+  mapped_vertices.reserve(ids.size());
+  for (auto id : ids) {
+    mapped_vertices.push_back(std::invoke(mapper, graph.get_vertex(id)));
+  }
+  return detail::map_with(graph, ids, std::move(mapped_vertices));
+}
+
+// Same as `map`, but the mapper is invoked concurrently by `jobs` threads, so it must be thread-safe
+template <typename Vertex, typename Edge, graaf::graph_type Graph_type, std::invocable<Vertex> Mapper>
+[[nodiscard]] auto parallel_map(graaf::graph<Vertex, Edge, Graph_type> const& graph,
+                                Mapper const& mapper,
+                                std::size_t jobs)
+    -> graaf::graph<std::invoke_result_t<Mapper, Vertex>, Edge, Graph_type> {
+  std::vector<graaf::vertex_id_t> ids{detail::sorted_vertex_ids(graph)};
+  auto mapped_vertices{detail::parallel_transform(
+      std::span<graaf::vertex_id_t const>{ids},
+      [&graph, &mapper](graaf::vertex_id_t id) { return std::invoke(mapper, graph.get_vertex(id)); },
+      jobs)};
+  return detail::map_with(graph, ids, std::move(mapped_vertices));
 }
 }  // namespace cppcia
 
@@ -0,0 +1,50 @@
+#ifndef CPPCIA_INDEX_DIFF_HPP
+#define CPPCIA_INDEX_DIFF_HPP
+
+#include <vector>
+
+#include <clangd/index/Ref.h>
+#include <clangd/index/Symbol.h>
+#include <clangd/support/Path.h>
+
+namespace cppcia {
+struct Index_slabs {
+ public:
+  // NOLINTBEGIN(*non-private-member*)
+  clang::clangd::SymbolSlab symbols;
+  clang::clangd::RefSlab refs;
+  // NOLINTEND(*non-private-member*)
+};
+
+// The symbol table and references of a clangd index file, as `load_index` reads them. Throws `std::runtime_error` if it
+// can't be read.
+[[nodiscard]] auto load_slabs(clang::clangd::PathRef index_file) -> Index_slabs;
+[[nodiscard]] auto load_symbols(clang::clangd::PathRef index_file) -> clang::clangd::SymbolSlab;
+
+enum class Symbol_change { added, removed, changed };
+
+struct Changed_symbol {
+ public:
+  // NOLINTBEGIN(*non-private-member*)
+  Symbol_change change;
+  clang::clangd::Symbol const* symbol;  // in the old slab if removed, in the new slab otherwise
+  // NOLINTEND(*non-private-member*)
+};
+
+// Symbols of both slabs are joined by their IDs, which slabs keep sorted. A symbol is changed when its kind, signature,
+// type or template arguments differ, or when its definition or canonical declaration moved to another file or spans
+// other lines and columns. Declarations merely shifted by edits above them are not changed. The index has no hash of
+// bodies, so a body edit that keeps the extent is left to `--diff`.
+[[nodiscard]] auto diff_symbols(clang::clangd::SymbolSlab const& old_symbols,
+                                clang::clangd::SymbolSlab const& new_symbols) -> std::vector<Changed_symbol>;
+
+// A removed symbol has no references left in the new index, so the symbols that referred to it are found by the
+// containers of its references in the old one. Those still in `new_symbols` and not in `changes` already are returned
+// as changed, sorted by their IDs.
+[[nodiscard]] auto find_referrers_of_removed(std::vector<Changed_symbol> const& changes,
+                                             clang::clangd::RefSlab const& old_refs,
+                                             clang::clangd::SymbolSlab const& new_symbols)
+    -> std::vector<Changed_symbol>;
+}  // namespace cppcia
+
+#endif
\ No newline at end of file
@@ -0,0 +1,177 @@
+#ifndef CPPCIA_JSON_HPP
+#define CPPCIA_JSON_HPP
+
+#include "cppcia/graph_util.hpp"
+#include "cppcia/reference.hpp"
+#include "cppcia/string_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include <clangd/Protocol.h>
+#include <graaflib/types.h>
+#include <magic_enum/magic_enum.hpp>
+#include <nlohmann/json.hpp>
+
+namespace cppcia {
+inline namespace cpo {
+  inline constexpr auto empty_json_writer{[](auto /*id*/, auto&& /*value*/) {
+    return nlohmann::json::object();
+  }};
+
+  inline constexpr auto edge_type_json_writer{[](auto /*id*/, Edge_type edge_type) -> nlohmann::json {
+    return nlohmann::json{{"edge_type", magic_enum::enum_name(edge_type)}};
+  }};
+}  // namespace cpo
+
+enum class Json_style : std::uint8_t {
+  array,         // One JSON array of all records, one record per line
+  lines,         // Newline-delimited JSON, i.e. one record per line and nothing else
+  inline_array,  // One JSON array of all records without any newline, e.g. to be embedded in a line-delimited message
+};
+
+// Writes every vertex and edge as a record as soon as it is received, `{"type": "vertex", "id": ...}` or
+// `{"type": "edge", "source": ..., "target": ...}` merged with the object returned by the writer. A vertex is always
+// written before the edges from or to it, so records can be consumed one by one. The output is closed by `finish`.
+template <typename Vertex,
+          typename Edge,
+          typename Vertex_writer_t,
+          typename Edge_writer_t = decltype(empty_json_writer)>
+  requires std::is_invocable_r_v<nlohmann::json, Vertex_writer_t const&, graaf::vertex_id_t, Vertex const&>
+           && std::is_invocable_r_v<nlohmann::json, Edge_writer_t const&, graaf::edge_id_t const&, Edge const&>
+class [[nodiscard]] Json_sink final : public Graph_sink<Vertex, Edge> {
+ public:
+  Json_sink(std::ostream& ostream,
+            Json_style style,
+            Vertex_writer_t vertex_writer,
+            Edge_writer_t edge_writer = empty_json_writer)
+      : ostream_{&ostream},
+        style_{style},
+        vertex_writer_{std::move(vertex_writer)},
+        edge_writer_{std::move(edge_writer)} {
+    switch (style_) {
+      case Json_style::array:
+        *ostream_ << "[\n";
+        break;
+      case Json_style::lines:
+        break;
+      case Json_style::inline_array:
+        *ostream_ << '[';
+        break;
+    }
+  }
+
+  void add_vertex(graaf::vertex_id_t id, Vertex const& vertex) override {
+    nlohmann::json record{
+        {"type", "vertex"},
+        {"id", id},
+    };
+    record.update(std::invoke(vertex_writer_, id, vertex));
+    write(record);
+  }
+
+  void add_edge(graaf::vertex_id_t source, graaf::vertex_id_t target, Edge const& edge) override {
+    nlohmann::json record{
+        {"type", "edge"},
+        {"source", source},
+        {"target", target},
+    };
+    record.update(std::invoke(edge_writer_, graaf::edge_id_t{source, target}, edge));
+    write(record);
+  }
+
+  void finish() {
+    switch (style_) {
+      case Json_style::array:
+        *ostream_ << (written_ == 0 ? "]\n" : "\n]\n");
+        break;
+      case Json_style::lines:
+        break;
+      case Json_style::inline_array:
+        *ostream_ << ']';
+        break;
+    }
+  }
+
+ private:
+  void write(nlohmann::json const& record) {
+    if (written_ != 0) {
+      switch (style_) {
+        case Json_style::array:
+          *ostream_ << ",\n";
+          break;
+        case Json_style::lines:
+          break;
+        case Json_style::inline_array:
+          *ostream_ << ',';
+          break;
+      }
+    }
+    *ostream_ << record;
+    if (style_ == Json_style::lines) {
+      *ostream_ << '\n';
+    }
+    ++written_;
+  }
+
+  std::ostream* ostream_;
+  Json_style style_;
+  Vertex_writer_t vertex_writer_;
+  Edge_writer_t edge_writer_;
+  std::size_t written_{0};
+};
+
+namespace detail {
+  // In the shape of LSP ranges
+  [[nodiscard]] inline auto range_to_json(Range const& range) -> nlohmann::json {
+    return nlohmann::json{
+        {"start", {{"line", range.start.line}, {"character", range.start.character}}},
+        {"end", {{"line", range.end.line}, {"character", range.end.character}}},
+    };
+  }
+}  // namespace detail
+
+// Files are absolute unless a workspace root is given, and then relative to it, which is computed once per file.
+// Not thread-safe.
+class [[nodiscard]] Reference_json_writer {
+ public:
+  explicit Reference_json_writer(std::optional<std::filesystem::path> workspace_root = std::nullopt)
+      : workspace_root_{std::move(workspace_root)} {}
+
+  [[nodiscard]] auto operator()(graaf::vertex_id_t /*id*/, Reference const& reference) const -> nlohmann::json {
+    return nlohmann::json{
+        {"kind", magic_enum::enum_name(reference.kind)},
+        {"namespace_scopes", reference.namespace_scopes.view()},
+        {"local_scopes", reference.local_scopes.view()},
+        {"name", reference.name.view()},
+        {"file", file(reference.uri)},
+        {"name_range", detail::range_to_json(reference.name_range)},
+        {"full_range", reference.full_range ? detail::range_to_json(*reference.full_range) : nlohmann::json{}},
+        {"truncated", reference.truncated},
+    };
+  }
+
+ private:
+  [[nodiscard]] auto file(Interned_uri uri) const -> std::string const& {
+    auto [iter, inserted]{files_.try_emplace(uri)};
+    if (inserted) {
+      iter->second = workspace_root_ ? std::filesystem::relative(uri.file().data(), *workspace_root_).string()
+                                     : uri.file().str();
+    }
+    return iter->second;
+  }
+
+  std::optional<std::filesystem::path> workspace_root_;
+  mutable std::unordered_map<Interned_uri, std::string> files_;
+};
+}  // namespace cppcia
+
+#endif
\ No newline at end of file
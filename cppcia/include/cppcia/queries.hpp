@@ -0,0 +1,73 @@
+#ifndef CPPCIA_QUERIES_HPP
+#define CPPCIA_QUERIES_HPP
+
+#include "cppcia/reference.hpp"
+#include "cppcia/referencer.hpp"
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <clangd/Protocol.h>
+#include <llvm/ADT/StringRef.h>
+#include <nlohmann/json.hpp>
+
+namespace cppcia {
+// Throws `std::invalid_argument` if `path` doesn't exist
+[[nodiscard]] auto existing_absolute(std::filesystem::path const& path) -> std::string;
+[[nodiscard]] auto existing_absolute(std::string const& path) -> std::string;
+// Absolute and lexically normal, so that the spellings of one existing file are equal
+[[nodiscard]] auto canonical_file(std::string const& file) -> std::string;
+// `<path>:<line>:<column>`, where `<line>` and `<column>` start from 0
+[[nodiscard]] auto parse_location(llvm::StringRef location) -> std::pair<std::string, clang::clangd::Position>;
+// Trimmed, sorted and without duplicates
+[[nodiscard]] auto sorted_unique(std::vector<std::string> strings) -> std::vector<std::string>;
+
+// Symbols to query impacts of, as they are specified on the command line
+struct Queries {
+ public:
+  // NOLINTBEGIN(*non-private-member*)
+  std::vector<std::string> files;
+  std::vector<std::string> locations;
+  std::vector<std::string> names;
+  std::vector<std::string> names_fuzzy;
+  std::vector<std::string> diffs;        // unified diffs, whose changed lines query the symbols around them
+  std::vector<std::string> old_indexes;  // older index files, whose symbols changed since query themselves
+  // NOLINTEND(*non-private-member*)
+};
+
+void append(Queries& self, Queries other);
+
+// `{"files": [...], "locations": [...], "names": [...], "names_fuzzy": [...], "diffs": [...], "old_indexes": [...]}`,
+// each optional. Throws `std::invalid_argument` if it's not of this form.
+[[nodiscard]] auto json_queries(nlohmann::json const& json) -> Queries;
+// Either a JSON object as `json_queries` takes, or one query per line as `<kind> <value>`, where `<kind>` is `file`,
+// `location`, `name`, `name-fuzzy`, `diff` or `old-index` and `<value>` is as the option of the same name. Empty lines
+// and lines starting with `#` are skipped. Throws `std::invalid_argument` on an unknown kind or invalid JSON.
+[[nodiscard]] auto read_queries(std::string const& file) -> Queries;
+
+// What the impacts of a queried symbol follow besides its references
+struct Impact_options {
+ public:
+  // NOLINTBEGIN(*non-private-member*)
+  bool follow_contain_by{false};
+  bool follow_call{false};
+  bool follow_supertype{false};
+  bool follow_subtype{false};
+  std::string index_file;  // the index of the referencer, which `Queries::old_indexes` are compared to
+  // NOLINTEND(*non-private-member*)
+};
+
+// Each seed draws its hierarchy walks from one `Walk_budget`, so that the budgets bound every query however many
+// symbols it impacts
+using Seed = std::function<void(Referencer&, Reference_graph_builder&)>;
+
+// Queries are canonicalized and deduplicated first. Queries of the same file become one seed, so that the file is
+// opened by one worker only, which then sends the hovers of all its locations at once and queries its outline once
+// for all of its changed lines. The symbols changed since each old index become one seed as well.
+[[nodiscard]] auto collect_seeds(Queries const& queries, Impact_options const& options) -> std::vector<Seed>;
+}  // namespace cppcia
+
+#endif
\ No newline at end of file
@@ -2,18 +2,24 @@
 #define CPPCIA_REFERENCE_HPP
 
 #include "cppcia/detail/hash_value.hpp"
+#include "cppcia/frozen_graph.hpp"
+#include "cppcia/graph_util.hpp"
+#include "cppcia/string_pool.hpp"
 
+#include <cassert>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <gsl/gsl>
 #include <optional>
+#include <span>
 #include <string>
-#include <tuple>
 #include <utility>
 #include <vector>
 
 #include <clangd/Protocol.h>
+#include <clangd/index/SymbolID.h>
 #include <clangd/support/Path.h>
 #include <fmt/core.h>
 #include <fmt/ostream.h>
@@ -26,25 +32,44 @@ using clang::clangd::Range;
 using clang::clangd::SymbolKind;
 using clang::clangd::URIForFile;
 
+// A symbol is identified by where its name is written and by the name itself, since macro expansions and implicit
+// symbols may share a name range. The other textual fields only describe it. All of them are interned, so identity
+// comes down to a few integer compares.
 struct Reference {
  public:
   [[nodiscard]] friend auto operator==(Reference const& lhs, Reference const& rhs) -> bool {
-    return std::tie(lhs.kind, lhs.uri, lhs.name_range, lhs.namespace_scopes, lhs.local_scopes, lhs.name)
-           == std::tie(rhs.kind, rhs.uri, rhs.name_range, rhs.namespace_scopes, rhs.local_scopes, rhs.name);
+    return lhs.name_range == rhs.name_range && lhs.kind == rhs.kind && lhs.name == rhs.name && lhs.uri == rhs.uri;
   }
 
   [[nodiscard]] auto contains(Reference const& reference) const -> bool;
 
   // NOLINTBEGIN(*non-private-member*)
   SymbolKind kind;
-  URIForFile uri;
+  Interned_uri uri;
   Range name_range;
   std::optional<Range> full_range;
-  std::string namespace_scopes;
-  std::string local_scopes;
-  std::string name;
+  Interned_string namespace_scopes;
+  Interned_string local_scopes;
+  Interned_string name;
+  clang::clangd::SymbolID symbol_id;  // null if the symbol is not resolved through the index
+  bool truncated{false};              // a hierarchy walk ran out of budget before expanding this symbol
+  bool expanded{false};               // a hierarchy walk reached every symbol next to this one
   // NOLINTEND(*non-private-member*)
 };
+
+// A symbol cut off by one walk is complete if another walk expanded it, while a vertex collapsing several symbols, e.g.
+// a file, is truncated if any of them is
+template <>
+struct Vertex_traits<Reference> {
+ public:
+  static void merge_copy(Reference& kept, Reference const& copy) {
+    kept.expanded  = kept.expanded || copy.expanded;
+    kept.truncated = !kept.expanded && (kept.truncated || copy.truncated);
+  }
+  static void collapse(Reference& kept, Reference const& collapsed) {
+    kept.truncated = kept.truncated || collapsed.truncated;
+  }
+};
 }  // namespace cppcia
 
 template <>
@@ -55,42 +80,101 @@ struct std::hash<cppcia::Reference> {
  public:
   [[nodiscard]] auto operator()(cppcia::Reference const& reference) const -> std::size_t {
     return cppcia::detail::hash_value(reference.kind,
-                                      reference.uri.file().str(),
+                                      reference.uri,
+                                      reference.name,
                                       reference.name_range.start.line,
                                       reference.name_range.start.character,
                                       reference.name_range.end.line,
-                                      reference.name_range.end.character,
-                                      reference.namespace_scopes,
-                                      reference.local_scopes,
-                                      reference.name);
+                                      reference.name_range.end.character);
   }
 };
 
 namespace cppcia {
 [[nodiscard]] auto make_file_reference(llvm::StringRef file) -> Reference;
 [[nodiscard]] auto make_file_reference(URIForFile uri) -> Reference;
+// Reuses the interned file of `uri` as is, without canonicalizing it again
+[[nodiscard]] auto make_file_reference(Interned_uri uri) -> Reference;
 
 [[nodiscard]] auto to_file_pos(URIForFile const& uri,
                                Range const& range) -> std::pair<std::string, clang::clangd::Position>;
 [[nodiscard]] auto to_file_pos(Location const& location) -> std::pair<std::string, clang::clangd::Position>;
 [[nodiscard]] auto to_file_pos(Reference const& reference) -> std::pair<std::string, clang::clangd::Position>;
 
-struct Reference_tree {
-  Reference reference;
-  std::vector<Reference_tree> children;
+// A tree flattened into one array of nodes, where the children of each node are stored next to each other. It is
+// built and traversed by index, so deep trees need neither recursion nor an allocation per node.
+class Reference_tree {
+ public:
+  using Node_id = std::size_t;
+  static constexpr Node_id root_id{0};
+
+  struct Node {
+   public:
+    // NOLINTBEGIN(*non-private-member*)
+    Reference reference;
+    Node_id parent;  // the root is its own parent
+    Node_id first_child;
+    std::size_t child_count;
+    // NOLINTEND(*non-private-member*)
+  };
+
+  explicit Reference_tree(Reference root) {
+    nodes_.push_back(Node{.reference{std::move(root)}, .parent{root_id}, .first_child{0}, .child_count{0}});
+  }
+
+  // All children of a node are added at once so that they stay contiguous, returns the id of the first one
+  auto add_children(Node_id parent, std::vector<Reference> children) -> Node_id {
+    assert(nodes_[parent].child_count == 0);
+    Node_id const first_child{nodes_.size()};
+    nodes_[parent].first_child = first_child;
+    nodes_[parent].child_count = children.size();
+    for (auto& child : children) {
+      nodes_.push_back(Node{.reference{std::move(child)}, .parent{parent}, .first_child{0}, .child_count{0}});
+    }
+    return first_child;
+  }
+  auto add_child(Node_id parent, Reference child) -> Node_id {
+    return add_children(parent, {std::move(child)});
+  }
+
+  [[nodiscard]] auto root() const -> Reference const& {
+    return nodes_.front().reference;
+  }
+  [[nodiscard]] auto node(Node_id id) const -> Node const& {
+    return nodes_[id];
+  }
+  [[nodiscard]] auto children(Node const& node) const -> std::span<Node const> {
+    return std::span<Node const>{nodes_}.subspan(node.first_child, node.child_count);
+  }
+  [[nodiscard]] auto children(Node_id id) const -> std::span<Node const> {
+    return children(nodes_[id]);
+  }
+  [[nodiscard]] auto id_of(Node const& node) const -> Node_id {
+    return gsl::narrow_cast<Node_id>(&node - nodes_.data());
+  }
+
+  // Every node with parents before their children, i.e. the root first
+  [[nodiscard]] auto nodes() const -> std::span<Node const> {
+    return nodes_;
+  }
+  [[nodiscard]] auto size() const -> std::size_t {
+    return nodes_.size();
+  }
+
+ private:
+  std::vector<Node> nodes_;
 };
 
-void visit(std::convertible_to<Reference_tree> auto&& tree,
-           std::invocable<Reference> auto&& function) {  // NOLINT(*recursion*)
-  std::invoke(function, tree.reference);
-  for (auto& child : tree.children) {
-    visit(child, function);
+void visit(Reference_tree const& tree, std::invocable<Reference> auto&& function) {
+  for (auto const& node : tree.nodes()) {
+    std::invoke(function, node.reference);
   }
 }
 
 enum class Edge_type : std::uint8_t { solid, dashed, dotted };
 
-using Reference_graph = graaf::directed_graph<Reference, Edge_type>;
+using Reference_graph         = graaf::directed_graph<Reference, Edge_type>;
+using Reference_graph_builder = Graph_builder<Reference, Edge_type, graaf::graph_type::DIRECTED>;
+using Frozen_reference_graph  = Frozen_graph<Reference, Edge_type>;
 
 [[nodiscard]] auto to_graph(Reference_tree const& tree, Edge_type edge_type, bool reverse_edge) -> Reference_graph;
 }  // namespace cppcia
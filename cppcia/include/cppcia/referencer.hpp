@@ -1,23 +1,72 @@
 #ifndef CPPCIA_REFERENCER_HPP
 #define CPPCIA_REFERENCER_HPP
 
+#include "cppcia/detail/hash_value.hpp"
 #include "cppcia/extractor.hpp"
 #include "cppcia/reference.hpp"
+#include "cppcia/string_pool.hpp"
 
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include <clangd/Protocol.h>
+#include <clangd/index/Symbol.h>
 #include <clangd/support/Path.h>
 #include <graaflib/graph.h>
+#include <llvm/ADT/StringMap.h>
 #include <llvm/ADT/StringRef.h>
 
 namespace cppcia {
+namespace detail {
+  class [[nodiscard]] Position_hash {
+   public:
+    [[nodiscard]] auto operator()(clang::clangd::Position const& pos) const -> std::size_t {
+      return hash_value(pos.line, pos.character);
+    }
+  };
+}  // namespace detail
+
+struct Referencer_options {
+ public:
+  // NOLINTBEGIN(*non-private-member*)
+  bool index_only{false};  // Resolve references and hierarchies from the static index alone instead of parsing files
+
+  // Budgets of hierarchy walks, symbols left unexpanded when one runs out are marked `truncated`. The depth bounds each
+  // walk, the vertices and the time are shared by the walks drawing from one `Walk_budget`.
+  std::optional<std::size_t> max_depth;
+  std::optional<std::size_t> max_vertices;
+  std::optional<std::chrono::milliseconds> timeout;
+  // NOLINTEND(*non-private-member*)
+};
+
+// What is left of the budgets of some hierarchy walks, usually those of one query. The deadline starts when it's made.
+class Walk_budget {
+ public:
+  explicit Walk_budget(Referencer_options const& options);
+
+  [[nodiscard]] auto out_of_depth(std::size_t depth) const -> bool;
+  [[nodiscard]] auto out_of_vertices() const -> bool;
+  [[nodiscard]] auto out_of_time() const -> bool;
+  // Counts a vertex added by a walk, the roots of walks are not counted since they're known before walking
+  void take_vertex();
+
+ private:
+  std::optional<std::size_t> max_depth_;
+  std::optional<std::size_t> vertices_left_;
+  std::optional<std::chrono::steady_clock::time_point> deadline_;
+};
+
 class Referencer {
  public:
-  explicit Referencer(Extractor extractor, bool for_test = false)
-      : extractor_{std::move(extractor)}, for_test_{for_test} {}
+  explicit Referencer(Extractor extractor, bool for_test = false, Referencer_options options = {})
+      : extractor_{std::move(extractor)}, for_test_{for_test}, options_{options} {}
 
   void update_file(clang::clangd::PathRef file, llvm::StringRef content);
 
@@ -28,7 +77,13 @@ class Referencer {
     auto [file, pos]{to_file_pos(location)};
     return query_location(file, pos);
   }
+  [[nodiscard]] auto query_locations(std::vector<File_position> const& positions)
+      -> std::vector<std::optional<Reference>>;
   [[nodiscard]] auto query_name(llvm::StringRef name, bool fuzzy = false) -> std::vector<Reference>;
+  // From the index alone, at the definition of `symbol` if it has one
+  [[nodiscard]] auto query_symbol(clang::clangd::Symbol const& symbol) -> std::optional<Reference> {
+    return to_index_reference(symbol);
+  }
 
   [[nodiscard]] auto find_container(Reference const& reference) -> Reference;
   [[nodiscard]] auto find_container_path(Reference const& reference) -> Reference_tree;
@@ -36,11 +91,51 @@ class Referencer {
   [[nodiscard]] auto find_preferred_declaration(Reference const& reference) -> std::optional<Reference>;
   [[nodiscard]] auto find_references(Reference const& reference) -> Reference_tree;
   [[nodiscard]] auto find_direct_callers(Reference const& reference) -> std::vector<Reference>;
-  [[nodiscard]] auto find_caller_hierarchies(Reference const& reference) -> Reference_tree;
+  // Hierarchy walks expand each symbol once, so cycles and diamonds collapse into shared vertices. Walks given the same
+  // `budget` share its vertices and time, a walk given none gets a budget of its own from the options. A walk adds each
+  // vertex to `output` once its truncation is known and each edge once both its ends are added, so a sink-backed
+  // builder receives the graph while the walk runs.
+  void find_caller_hierarchies(Reference const& reference,
+                               Reference_graph_builder& output,
+                               Edge_type edge_type = Edge_type::dashed,
+                               bool reverse_edge = false,
+                               Walk_budget* budget = nullptr);
+  [[nodiscard]] auto find_caller_hierarchies(Reference const& reference,
+                                             Edge_type edge_type = Edge_type::dashed,
+                                             bool reverse_edge = false,
+                                             Walk_budget* budget = nullptr) -> Reference_graph {
+    Reference_graph_builder output;
+    find_caller_hierarchies(reference, output, edge_type, reverse_edge, budget);
+    return std::move(output).build();
+  }
   [[nodiscard]] auto find_direct_supertypes(Reference const& reference) -> std::vector<Reference>;
-  [[nodiscard]] auto find_supertype_hierarchies(Reference const& reference) -> Reference_tree;
+  void find_supertype_hierarchies(Reference const& reference,
+                                  Reference_graph_builder& output,
+                                  Edge_type edge_type = Edge_type::dashed,
+                                  bool reverse_edge = false,
+                                  Walk_budget* budget = nullptr);
+  [[nodiscard]] auto find_supertype_hierarchies(Reference const& reference,
+                                                Edge_type edge_type = Edge_type::dashed,
+                                                bool reverse_edge = false,
+                                                Walk_budget* budget = nullptr) -> Reference_graph {
+    Reference_graph_builder output;
+    find_supertype_hierarchies(reference, output, edge_type, reverse_edge, budget);
+    return std::move(output).build();
+  }
   [[nodiscard]] auto find_direct_subtypes(Reference const& reference) -> std::vector<Reference>;
-  [[nodiscard]] auto find_subtype_hierarchies(Reference const& reference) -> Reference_tree;
+  void find_subtype_hierarchies(Reference const& reference,
+                                Reference_graph_builder& output,
+                                Edge_type edge_type = Edge_type::dashed,
+                                bool reverse_edge = false,
+                                Walk_budget* budget = nullptr);
+  [[nodiscard]] auto find_subtype_hierarchies(Reference const& reference,
+                                              Edge_type edge_type = Edge_type::dashed,
+                                              bool reverse_edge = false,
+                                              Walk_budget* budget = nullptr) -> Reference_graph {
+    Reference_graph_builder output;
+    find_subtype_hierarchies(reference, output, edge_type, reverse_edge, budget);
+    return std::move(output).build();
+  }
 
   [[nodiscard]] auto extractor() -> Extractor& {
     return extractor_;
@@ -50,15 +145,42 @@ class Referencer {
     return extractor_;
   }
 
+  [[nodiscard]] auto options() const -> Referencer_options const& {
+    return options_;
+  }
+
  private:
   void update_real_file_or_test(clang::clangd::PathRef file) {
-    if (!for_test_) {
-      update_file(file, read_file(file));
+    if (!for_test_ && extractor_.update_file(file)) {
+      std::scoped_lock const lock{*mutex_};
+      documents_.erase(file);
     }
   }
 
+  // The symbol tree of a file, where children of each node are sorted by their starts. Shared so that it outlives
+  // the cache entry if the file is updated by another thread meanwhile
+  [[nodiscard]] auto outline(clang::clangd::PathRef file) -> std::shared_ptr<Reference_tree const>;
+
+  // Splits an index scope like `a::b::Foo::` into the namespace scopes `a::b::` and the local scopes `Foo::`
+  [[nodiscard]] auto split_scope(llvm::StringRef scope) -> std::pair<Interned_string, Interned_string>;
+  [[nodiscard]] auto to_index_reference(clang::clangd::Symbol const& symbol) -> std::optional<Reference>;
+
+  // Queried results of a file, valid as long as the file content doesn't change
+  struct Document {
+   public:
+    // NOLINTBEGIN(*non-private-member*)
+    std::shared_ptr<Reference_tree const> outline;
+    std::unordered_map<clang::clangd::Position, std::optional<Reference>, detail::Position_hash> references;
+    // NOLINTEND(*non-private-member*)
+  };
+
   Extractor extractor_;
   bool for_test_;
+  Referencer_options options_;
+  // Guards the caches below, so that independent queries can run concurrently on one referencer
+  std::unique_ptr<std::mutex> mutex_{std::make_unique<std::mutex>()};
+  llvm::StringMap<Document> documents_;
+  llvm::StringMap<std::pair<Interned_string, Interned_string>> scope_splits_;
 };
 
 [[nodiscard]] inline auto to_reference(Referencer& referencer,
@@ -0,0 +1,58 @@
+#ifndef CPPCIA_RESULT_CACHE_HPP
+#define CPPCIA_RESULT_CACHE_HPP
+
+#include "cppcia/binary_graph.hpp"
+#include "cppcia/frozen_graph.hpp"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <llvm/Support/SHA256.h>
+
+namespace cppcia {
+// Digest of everything a cached result depends on. Parts are added in order and can't run into each other.
+class Cache_key {
+ public:
+  void add(std::string_view part);
+  // Adds a digest of the content of `file`, or a marker if it doesn't exist
+  void add_file(std::filesystem::path const& file);
+
+  [[nodiscard]] auto digest() && -> std::string;
+
+ private:
+  llvm::SHA256 sha256_;
+};
+
+// Fast digest of the content of `file`, or `std::nullopt` if it can't be read. Index files can be huge, so this is
+// meant to be far cheaper than reading them into clangd.
+[[nodiscard]] auto content_digest(std::filesystem::path const& file) -> std::optional<std::string>;
+
+// Graphs stored in binary format under the digests of their queries. Each graph comes with the digests of its source
+// files, and is only found again while they all still have the same contents.
+class Result_cache {
+ public:
+  explicit Result_cache(std::filesystem::path directory) : directory_{std::move(directory)} {}
+
+  [[nodiscard]] auto lookup(std::string_view key) const -> std::optional<Mapped_reference_graph>;
+  // Entries are written to temporary files and renamed into place, so concurrent runs never see half an entry.
+  // Failing to store is not an error, the result just won't be cached.
+  void store(std::string_view key, Frozen_reference_graph const& graph, std::vector<std::string> const& sources) const;
+
+  [[nodiscard]] auto graph_file(std::string_view key) const -> std::filesystem::path {
+    return directory_ / (std::string{key} + ".graph");
+  }
+
+ private:
+  [[nodiscard]] auto sources_file(std::string_view key) const -> std::filesystem::path {
+    return directory_ / (std::string{key} + ".sources");
+  }
+
+  std::filesystem::path directory_;
+};
+}  // namespace cppcia
+
+#endif
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef CPPCIA_SERVER_HPP
+#define CPPCIA_SERVER_HPP
+
+#include "cppcia/reference.hpp"
+#include "cppcia/referencer.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <nlohmann/json.hpp>
+
+namespace cppcia {
+// Error codes defined by JSON-RPC 2.0
+enum class Rpc_error : std::int16_t {
+  parse_error      = -32700,
+  invalid_request  = -32600,
+  method_not_found = -32601,
+  invalid_params   = -32602,
+  internal_error   = -32603,
+};
+
+class Rpc_exception : public std::runtime_error {
+ public:
+  Rpc_exception(Rpc_error code, std::string const& message) : std::runtime_error{message}, code_{code} {}
+
+  [[nodiscard]] auto code() const -> Rpc_error {
+    return code_;
+  }
+
+ private:
+  Rpc_error code_;
+};
+
+// Answers JSON-RPC 2.0 messages, one per line, with the same referencer, so that the index, the compilation database
+// and parsed files stay warm across queries. Methods are
+// - `impact`: params a JSON object of queries as `--queries` takes, result the records of the graph in the same format
+//   as `--format=json`
+// - `update_file`: params `{"file": ..., "content": ...}`, where `content` replaces the file on disk until it is
+//   modified there, or the file is read again from disk if it is omitted
+// - `exit`: stops serving
+// Requests are served one at a time.
+class Server {
+ public:
+  // Builds the graph of the params of an `impact` request. `std::invalid_argument` is answered as invalid params.
+  using Impact = std::function<Frozen_reference_graph(nlohmann::json const& params)>;
+
+  Server(Referencer& referencer, Impact impact, std::optional<std::filesystem::path> workspace_root)
+      : referencer_{&referencer}, impact_{std::move(impact)}, workspace_root_{std::move(workspace_root)} {}
+
+  // Serves until `exit` is requested or `istream` ends
+  void serve(std::istream& istream, std::ostream& ostream);
+
+ private:
+  void handle(std::string const& line, std::ostream& ostream);
+  void impact(nlohmann::json const& id, nlohmann::json const& params, std::ostream& ostream);
+  void update_file(nlohmann::json const& params);
+
+  Referencer* referencer_;
+  Impact impact_;
+  std::optional<std::filesystem::path> workspace_root_;
+  bool exiting_{false};
+};
+}  // namespace cppcia
+
+#endif
\ No newline at end of file
@@ -0,0 +1,96 @@
+#ifndef CPPCIA_STRING_POOL_HPP
+#define CPPCIA_STRING_POOL_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include <clangd/Protocol.h>
+#include <llvm/ADT/StringRef.h>
+
+namespace cppcia {
+// Stores `string` once in a process-wide arena and returns a view of it, valid until the program exits.
+// Equal strings are interned to the same storage. Safe to call from several threads.
+[[nodiscard]] auto intern(std::string_view string) -> std::string_view;
+
+// A string interned by `intern`, so that copying it is free and equal strings are compared and hashed by address
+class [[nodiscard]] Interned_string {
+ public:
+  Interned_string() = default;
+  explicit Interned_string(std::string_view string) : view_{string.empty() ? std::string_view{} : intern(string)} {}
+
+  [[nodiscard]] friend auto operator==(Interned_string lhs, Interned_string rhs) -> bool {
+    return lhs.view_.data() == rhs.view_.data();
+  }
+  [[nodiscard]] friend auto operator==(Interned_string lhs, std::string_view rhs) -> bool {
+    return lhs.view_ == rhs;
+  }
+
+  [[nodiscard]] auto view() const -> std::string_view {
+    return view_;
+  }
+  [[nodiscard]] auto str() const -> std::string {
+    return std::string{view_};
+  }
+  [[nodiscard]] auto empty() const -> bool {
+    return view_.empty();
+  }
+
+  operator std::string_view() const {  // NOLINT(*explicit*)
+    return view_;
+  }
+  operator llvm::StringRef() const {  // NOLINT(*explicit*)
+    return llvm::StringRef{view_.data(), view_.size()};
+  }
+
+ private:
+  std::string_view view_;
+};
+
+// The file of a canonicalized `URIForFile`, interned
+class [[nodiscard]] Interned_uri {
+ public:
+  Interned_uri() = default;
+  explicit Interned_uri(clang::clangd::URIForFile const& uri) : file_{uri.file()} {}
+
+  // `file` must already be canonical, e.g. the `file()` of another `Interned_uri` read back from somewhere
+  [[nodiscard]] static auto from_canonical_file(std::string_view file) -> Interned_uri {
+    Interned_uri result;
+    result.file_ = Interned_string{file};
+    return result;
+  }
+
+  [[nodiscard]] friend auto operator==(Interned_uri lhs, Interned_uri rhs) -> bool {
+    return lhs.file_ == rhs.file_;
+  }
+
+  [[nodiscard]] auto file() const -> llvm::StringRef {
+    return file_;
+  }
+  [[nodiscard]] auto interned_file() const -> Interned_string {
+    return file_;
+  }
+
+ private:
+  Interned_string file_;
+};
+}  // namespace cppcia
+
+template <>
+struct std::hash<cppcia::Interned_string> {
+ public:
+  [[nodiscard]] auto operator()(cppcia::Interned_string string) const -> std::size_t {
+    return std::hash<char const*>{}(string.view().data());
+  }
+};
+
+template <>
+struct std::hash<cppcia::Interned_uri> {
+ public:
+  [[nodiscard]] auto operator()(cppcia::Interned_uri uri) const -> std::size_t {
+    return std::hash<cppcia::Interned_string>{}(uri.interned_file());
+  }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include "cppcia/binary_graph.hpp"
+
+#include "cppcia/reference.hpp"
+#include "cppcia/string_pool.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <gsl/gsl>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <clangd/Protocol.h>
+#include <clangd/index/SymbolID.h>
+#include <fmt/core.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Alignment.h>
+#include <llvm/Support/ErrorOr.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <magic_enum/magic_enum.hpp>
+
+namespace cppcia {
+namespace {
+  using namespace detail::binary;  // NOLINT(*using-namespace*)
+
+  constexpr std::uint64_t section_alignment{8};
+
+  [[nodiscard]] constexpr auto aligned(std::uint64_t offset) -> std::uint64_t {
+    return (offset + section_alignment - 1) / section_alignment * section_alignment;
+  }
+
+  [[nodiscard]] auto to_record(Range const& range) -> Range_record {
+    return Range_record{.start_line{range.start.line},
+                        .start_character{range.start.character},
+                        .end_line{range.end.line},
+                        .end_character{range.end.character}};
+  }
+
+  [[nodiscard]] auto from_record(Range_record const& record) -> Range {
+    return Range{.start{.line{record.start_line}, .character{record.start_character}},
+                 .end{.line{record.end_line}, .character{record.end_character}}};
+  }
+
+  // Stores each distinct interned string once
+  class String_table {
+   public:
+    [[nodiscard]] auto add(Interned_string string) -> String_ref {
+      auto [iter, inserted]{refs_.try_emplace(string)};
+      if (inserted) {
+        if (strings_.size() + string.view().size() > std::numeric_limits<std::uint32_t>::max()) {
+          throw std::length_error{"Too many strings for a binary graph"};
+        }
+        iter->second = String_ref{.offset{gsl::narrow_cast<std::uint32_t>(strings_.size())},
+                                  .size{gsl::narrow_cast<std::uint32_t>(string.view().size())}};
+        strings_ += string.view();
+      }
+      return iter->second;
+    }
+
+    [[nodiscard]] auto strings() const -> std::string const& {
+      return strings_;
+    }
+
+   private:
+    std::unordered_map<Interned_string, String_ref> refs_;
+    std::string strings_;
+  };
+
+  template <typename T>
+  void write_span(std::ostream& ostream, std::span<T const> span) {
+    ostream.write(reinterpret_cast<char const*>(span.data()),  // NOLINT(*reinterpret-cast*)
+                  gsl::narrow_cast<std::streamsize>(span.size_bytes()));
+  }
+
+  void write_padding(std::ostream& ostream, std::uint64_t from, std::uint64_t to) {
+    std::array<char, section_alignment> const zeros{};
+    ostream.write(zeros.data(), gsl::narrow_cast<std::streamsize>(to - from));
+  }
+
+  // Checks that `count` objects of `T` at `offset` lie inside `buffer` and are aligned before viewing them in place
+  template <typename T>
+  [[nodiscard]] auto section(llvm::MemoryBuffer const& buffer,
+                             std::uint64_t offset,
+                             std::uint64_t count) -> std::span<T const> {
+    if (offset % alignof(T) != 0 || offset > buffer.getBufferSize()
+        || count > (buffer.getBufferSize() - offset) / sizeof(T)) {
+      throw std::runtime_error{
+          fmt::format("{} is not a valid binary graph: section out of bounds", buffer.getBufferIdentifier().str())};
+    }
+    // NOLINTNEXTLINE(*reinterpret-cast*, *pointer-arithmetic*)
+    return std::span<T const>{reinterpret_cast<T const*>(buffer.getBufferStart() + offset),
+                              gsl::narrow_cast<std::size_t>(count)};
+  }
+}  // namespace
+
+void write_binary(std::ostream& ostream, Frozen_reference_graph const& graph) {
+  if (graph.vertex_count() > std::numeric_limits<std::uint32_t>::max()) {
+    throw std::length_error{"Too many vertices for a binary graph"};
+  }
+
+  String_table strings;
+  std::vector<Vertex_record> vertices;
+  vertices.reserve(graph.vertex_count());
+  for (auto const& reference : graph.vertices()) {
+    Vertex_record record{.kind{static_cast<std::uint32_t>(reference.kind)},
+                         .flags{(reference.truncated ? Vertex_record::truncated : 0U)
+                                | (reference.full_range ? Vertex_record::has_full_range : 0U)},
+                         .file{strings.add(reference.uri.interned_file())},
+                         .namespace_scopes{strings.add(reference.namespace_scopes)},
+                         .local_scopes{strings.add(reference.local_scopes)},
+                         .name{strings.add(reference.name)},
+                         .name_range{to_record(reference.name_range)},
+                         .full_range{to_record(reference.full_range.value_or(Range{}))},
+                         .symbol_id{}};
+    auto const raw_id{reference.symbol_id.raw()};
+    std::memcpy(record.symbol_id.data(), raw_id.data(), record.symbol_id.size());
+    vertices.push_back(record);
+  }
+
+  std::vector<std::uint64_t> offsets{0};
+  offsets.reserve(graph.vertex_count() + 1);
+  std::vector<std::uint32_t> targets;
+  targets.reserve(graph.edge_count());
+  std::vector<Edge_type> edge_types;
+  edge_types.reserve(graph.edge_count());
+  for (graaf::vertex_id_t id{0}; id < graph.vertex_count(); ++id) {
+    for (auto target : graph.targets(id)) {
+      targets.push_back(gsl::narrow_cast<std::uint32_t>(target));
+    }
+    for (auto edge_type : graph.edges(id)) {
+      edge_types.push_back(edge_type);
+    }
+    offsets.push_back(targets.size());
+  }
+
+  Header header{.magic{magic},
+                .version{version},
+                .byte_order{byte_order_mark},
+                .vertex_count{vertices.size()},
+                .edge_count{targets.size()},
+                .vertices_offset{aligned(sizeof(Header))},
+                .offsets_offset{0},
+                .targets_offset{0},
+                .edge_types_offset{0},
+                .strings_offset{0},
+                .strings_size{strings.strings().size()}};
+  header.offsets_offset    = aligned(header.vertices_offset + (vertices.size() * sizeof(Vertex_record)));
+  header.targets_offset    = aligned(header.offsets_offset + (offsets.size() * sizeof(std::uint64_t)));
+  header.edge_types_offset = aligned(header.targets_offset + (targets.size() * sizeof(std::uint32_t)));
+  header.strings_offset    = aligned(header.edge_types_offset + (edge_types.size() * sizeof(Edge_type)));
+
+  write_span(ostream, std::span<Header const>{&header, 1});
+  write_padding(ostream, sizeof(Header), header.vertices_offset);
+  write_span(ostream, std::span<Vertex_record const>{vertices});
+  write_padding(ostream, header.vertices_offset + (vertices.size() * sizeof(Vertex_record)), header.offsets_offset);
+  write_span(ostream, std::span<std::uint64_t const>{offsets});
+  write_padding(ostream, header.offsets_offset + (offsets.size() * sizeof(std::uint64_t)), header.targets_offset);
+  write_span(ostream, std::span<std::uint32_t const>{targets});
+  write_padding(ostream, header.targets_offset + (targets.size() * sizeof(std::uint32_t)), header.edge_types_offset);
+  write_span(ostream, std::span<Edge_type const>{edge_types});
+  write_padding(ostream, header.edge_types_offset + (edge_types.size() * sizeof(Edge_type)), header.strings_offset);
+  ostream.write(strings.strings().data(), gsl::narrow_cast<std::streamsize>(strings.strings().size()));
+}
+
+Mapped_reference_graph::Mapped_reference_graph(llvm::StringRef file) {
+  // Large files are mapped rather than read, and the alignment lets records be viewed in place either way
+  auto buffer{llvm::MemoryBuffer::getFile(file,
+                                          /*IsText=*/false,
+                                          /*RequiresNullTerminator=*/false,
+                                          /*IsVolatile=*/false,
+                                          llvm::Align{section_alignment})};
+  if (!buffer) {
+    throw std::runtime_error{fmt::format("Failed to read {}: {}", file.str(), buffer.getError().message())};
+  }
+  buffer_ = std::move(*buffer);
+
+  auto const header{section<Header>(*buffer_, 0, 1)};
+  if (header.front().magic != magic) {
+    throw std::runtime_error{fmt::format("{} is not a binary graph", file.str())};
+  }
+  if (header.front().byte_order != byte_order_mark) {
+    throw std::runtime_error{fmt::format("{} is a binary graph written in another byte order", file.str())};
+  }
+  if (header.front().version != version) {
+    throw std::runtime_error{fmt::format(
+        "{} is a binary graph of version {}, but version {} is expected", file.str(), header.front().version, version)};
+  }
+
+  vertices_   = section<Vertex_record>(*buffer_, header.front().vertices_offset, header.front().vertex_count);
+  offsets_    = section<std::uint64_t>(*buffer_, header.front().offsets_offset, header.front().vertex_count + 1);
+  targets_    = section<std::uint32_t>(*buffer_, header.front().targets_offset, header.front().edge_count);
+  edge_types_ = section<Edge_type>(*buffer_, header.front().edge_types_offset, header.front().edge_count);
+  auto const strings{section<char>(*buffer_, header.front().strings_offset, header.front().strings_size)};
+  strings_ = std::string_view{strings.data(), strings.size()};
+
+  validate(file);
+}
+
+void Mapped_reference_graph::validate(llvm::StringRef file) const {
+  auto const check{[file](bool valid, std::string_view what) {
+    if (!valid) {
+      throw std::runtime_error{fmt::format("{} is not a valid binary graph: {}", file.str(), what)};
+    }
+  }};
+
+  check(offsets_.front() == 0, "edges of the first vertex don't start at 0");
+  for (std::size_t i{0}; i + 1 < offsets_.size(); ++i) {
+    check(offsets_[i] <= offsets_[i + 1], "edge offsets decrease");
+  }
+  check(offsets_.back() == edge_count(), "edges of the last vertex don't end at the edge count");
+
+  for (auto target : targets_) {
+    check(target < vertex_count(), "edge target out of bounds");
+  }
+  for (auto edge_type : edge_types_) {
+    check(magic_enum::enum_contains(edge_type), "unknown edge type");
+  }
+
+  auto const check_string{[this, &check](String_ref ref) {
+    check(std::uint64_t{ref.offset} + ref.size <= strings_.size(), "string out of bounds");
+  }};
+  for (auto const& record : vertices_) {
+    check(magic_enum::enum_contains<SymbolKind>(gsl::narrow_cast<int>(record.kind)), "unknown symbol kind");
+    check_string(record.file);
+    check_string(record.namespace_scopes);
+    check_string(record.local_scopes);
+    check_string(record.name);
+  }
+}
+
+auto Mapped_reference_graph::vertex(Vertex_id id) const -> Reference {
+  auto const& record{vertices_[id]};
+  return Reference{
+      .kind{static_cast<SymbolKind>(record.kind)},
+      .uri{Interned_uri::from_canonical_file(string(record.file))},
+      .name_range{from_record(record.name_range)},
+      .full_range{(record.flags & Vertex_record::has_full_range) != 0
+                      ? std::optional<Range>{from_record(record.full_range)}
+                      : std::nullopt},
+      .namespace_scopes{Interned_string{string(record.namespace_scopes)}},
+      .local_scopes{Interned_string{string(record.local_scopes)}},
+      .name{Interned_string{string(record.name)}},
+      .symbol_id{clang::clangd::SymbolID::fromRaw(llvm::StringRef{record.symbol_id.data(), record.symbol_id.size()})},
+      .truncated{(record.flags & Vertex_record::truncated) != 0},
+      .expanded{false}};
+}
+
+auto Mapped_reference_graph::to_frozen() const -> Frozen_reference_graph {
+  std::vector<Reference> vertices;
+  vertices.reserve(vertex_count());
+  std::vector<Frozen_reference_graph::Edge_entry> edges;
+  edges.reserve(edge_count());
+  for (Vertex_id id{0}; id < vertex_count(); ++id) {
+    vertices.push_back(vertex(id));
+    auto const targets{this->targets(id)};
+    auto const edge_types{this->edge_types(id)};
+    for (std::size_t i{0}; i < targets.size(); ++i) {
+      edges.push_back(Frozen_reference_graph::Edge_entry{.source{id}, .target{targets[i]}, .edge{edge_types[i]}});
+    }
+  }
+  return Frozen_reference_graph{std::move(vertices), std::move(edges)};
+}
+
+void send_to(Graph_sink<Reference, Edge_type>& sink, Mapped_reference_graph const& graph) {
+  for (graaf::vertex_id_t id{0}; id < graph.vertex_count(); ++id) {
+    sink.add_vertex(id, graph.vertex(id));
+  }
+  for (graaf::vertex_id_t id{0}; id < graph.vertex_count(); ++id) {
+    auto const targets{graph.targets(id)};
+    auto const edge_types{graph.edge_types(id)};
+    for (std::size_t i{0}; i < targets.size(); ++i) {
+      sink.add_edge(id, targets[i], edge_types[i]);
+    }
+  }
+}
+}  // namespace cppcia
\ No newline at end of file
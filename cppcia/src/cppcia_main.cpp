@@ -1,19 +1,39 @@
 #include "cppcia/cppcia_main.hpp"
 
+#include "cppcia/binary_graph.hpp"
+#include "cppcia/diff.hpp"
 #include "cppcia/dot.hpp"
 #include "cppcia/extractor.hpp"
+#include "cppcia/frozen_graph.hpp"
 #include "cppcia/graph_util.hpp"
+#include "cppcia/json.hpp"
+#include "cppcia/queries.hpp"
 #include "cppcia/reference.hpp"
 #include "cppcia/referencer.hpp"
+#include "cppcia/result_cache.hpp"
+#include "cppcia/server.hpp"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <gsl/gsl>
+#include <ios>
+#include <iostream>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <ostream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -23,36 +43,32 @@
 #include <clangd/index/MemIndex.h>
 #include <clangd/index/Serialization.h>
 #include <clangd/support/Logger.h>
-#include <ctre.hpp>
 #include <fmt/core.h>
 #include <llvm/ADT/ArrayRef.h>
-#include <llvm/ADT/StringRef.h>
+#include <llvm/ADT/STLFunctionalExtras.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/FileSystem.h>
+#include <nlohmann/json.hpp>
+#include <range/v3/algorithm/none_of.hpp>
 
 namespace cppcia {
 namespace {
   using llvm::cl::cat;
   using llvm::cl::CommaSeparated;
   using llvm::cl::desc;
+  using llvm::cl::init;
   using llvm::cl::list;
   using llvm::cl::opt;
   using llvm::cl::OptionCategory;
   using llvm::cl::Positional;
   using llvm::cl::Required;
   using llvm::cl::ValueDisallowed;
+  using llvm::cl::values;
 
   using Path = std::string;
 
-  [[nodiscard]] auto existing_absolute(std::filesystem::path const& path) -> Path {
-    if (!std::filesystem::exists(path)) {
-      throw std::invalid_argument{fmt::format("Path {} dosen't exist!", path.string())};
-    }
-    return std::filesystem::absolute(path).string();
-  }
-  [[nodiscard]] auto existing_absolute(Path const& path) -> Path {
-    return existing_absolute(std::filesystem::path{path});
-  }
+  enum class Output_format : std::uint8_t { dot, json, ndjson, binary };
+
   [[nodiscard]] auto absolute(std::filesystem::path const& path) -> Path {
     return std::filesystem::absolute(path).string();
   }
@@ -76,6 +92,11 @@ namespace {
                                               "drivers that are safe to execute. Drivers matching any of these globs "
                                               "will be used to extract system includes. e.g. "
                                               "/usr/bin/**/clang-*,/path/to/repo/**/g++-*"}};
+    opt<bool> index_only{"index-only",
+                         ValueDisallowed,
+                         cat{index},
+                         desc{"Resolve references, callers and type hierarchies of symbols known by <index_file> "
+                              "from the index alone, without parsing the files involved"}};
 
     OptionCategory input{"cppcia input options"};
     list<Path> file{"file",
@@ -99,6 +120,24 @@ namespace {
                                  desc{"Fuzzy name queries. "
                                       "Name specfied by [namespace::][::]<name> can ignore some letters. "
                                       "e.g. array"}};
+    list<Path> diff{"diff",
+                    cat{input},
+                    desc{"Unified diff queries, e.g. from git diff. Every symbol around a changed line of the new "
+                         "version is queried. Paths in the diff are relative to the current directory. "
+                         "e.g. --diff changes.patch"}};
+    list<Path> old_index{"old-index",
+                         cat{input},
+                         desc{"Index file queries. Symbols added, removed or changed in <index_file> since the given "
+                              "older index are queried, without parsing any file to find them. Symbols that referred "
+                              "to a removed one in the older index are queried as changed. "
+                              "e.g. --old-index main.idx"}};
+    opt<Path> queries{"queries",
+                      cat{input},
+                      desc{"File of queries, in addition to the ones above. Either one query per line as "
+                           "<kind> <value>, where <kind> is file, location, name, name-fuzzy, diff or old-index, "
+                           "or a JSON object {\"files\": [...], \"locations\": [...], \"names\": [...], "
+                           "\"names_fuzzy\": [...], \"diffs\": [...], \"old_indexes\": [...]}. "
+                           "Duplicate queries are resolved once"}};
     opt<bool> follow_contain_by{
         "follow-contain-by", ValueDisallowed, cat{input}, desc{"Query result following contain-by impacts"}};
     opt<bool> follow_call{"follow-call", ValueDisallowed, cat{input}, desc{"Query result following call impacts"}};
@@ -107,8 +146,30 @@ namespace {
     opt<bool> follow_subtype{
         "follow-subtype", ValueDisallowed, cat{input}, desc{"Query result following subtype impacts"}};
 
+    opt<unsigned> max_depth{"max-depth",
+                            cat{input},
+                            desc{"Maximum levels followed by each call, supertype or subtype hierarchy. "
+                                 "Symbols left unexpanded are marked as truncated. 0 means unlimited"}};
+    opt<unsigned> max_vertices{"max-vertices",
+                               cat{input},
+                               desc{"Maximum symbols added by all call, supertype and subtype hierarchies of each "
+                                    "query, not counting the symbols they start from. "
+                                    "Queries of the same file count as one. "
+                                    "Symbols left unexpanded are marked as truncated. 0 means unlimited"}};
+    opt<unsigned> timeout{"timeout",
+                          cat{input},
+                          desc{"Maximum milliseconds spent on all call, supertype and subtype hierarchies of each "
+                               "query, counted from its start. Queries of the same file count as one. "
+                               "Symbols left unexpanded are marked as truncated. 0 means unlimited"}};
+
+    opt<unsigned> jobs{"j",
+                       cat{input},
+                       desc{"Number of queries resolved concurrently. "
+                            "0 means the number of hardware threads"},
+                       init(1)};
+
     OptionCategory output{"cppcia output Options"};
-    opt<Path> output_file{Positional, Required, cat{output}, desc{"<output_file>"}};
+    opt<Path> output_file{Positional, cat{output}, desc{"<output_file>, required unless serving"}};
     opt<Path> workspace_root{
         "workspace-root",
         cat{output},
@@ -116,218 +177,345 @@ namespace {
              "If not specified, paths in output graph will be absolute"},
     };
     opt<bool> file_level{"file-level", ValueDisallowed, cat{output}, desc{"Output file level graph"}};
-
-    std::array const categories{&index, &input, &output};
+    opt<Output_format> format{
+        "format",
+        cat{output},
+        desc{"Format of the output graph"},
+        values(clEnumValN(Output_format::dot, "dot", "Graphviz DOT"),
+               clEnumValN(Output_format::json, "json", "One JSON array of vertex and edge records"),
+               clEnumValN(Output_format::ndjson, "ndjson", "One JSON vertex or edge record per line"),
+               clEnumValN(Output_format::binary, "binary", "Compact binary graph, which can be memory-mapped")),
+        init(Output_format::dot)};
+    opt<bool> stream{"stream",
+                     ValueDisallowed,
+                     cat{output},
+                     desc{"Write impacts while the queries run rather than after all of them, each vertex once its "
+                          "hierarchy walk is done with it, flushing the output after each query. Neither the final "
+                          "graph nor formatted labels are held, but the vertices and edges written so far are still "
+                          "remembered to skip duplicates. Vertices are then numbered in the order they are found"}};
+
+    opt<Path> cache_dir{"cache-dir",
+                        cat{output},
+                        desc{"Directory of cached results. A query answered before with the same index, compile "
+                             "commands, options and contents of the files involved is read back from it without "
+                             "loading the index. Not used by --stream. Graphs truncated while --timeout is set are "
+                             "not stored"}};
+
+    OptionCategory server{"cppcia server options"};
+    opt<bool> serve{"serve",
+                    ValueDisallowed,
+                    cat{server},
+                    desc{"Keep running and answer JSON-RPC 2.0 requests read from stdin, one per line, on stdout. "
+                         "The index, compilation database and parsed files are kept across requests. "
+                         "Methods are impact, update_file and exit, see the source for their params"}};
+
+    std::array const categories{&index, &input, &output, &server};
   }  // namespace option
   // NOLINTEND(*non-const-global*, cert-err58-cpp)
 
-  [[nodiscard]] auto parse_location(llvm::StringRef location) -> std::pair<std::string, clang::clangd::Position> {
-    using namespace ctre::literals;  // NOLINT(*using-namespace*)
-    auto [whole, file, line, character]{R"ctre((.*?):(.*?):(.*?))ctre"_ctre.match(location)};
-    if (!whole) {
-      throw std::invalid_argument{fmt::format("{} is not a valid location!", location.data())};
-    }
-    return {file.to_string(), clang::clangd::Position{line.to_number(), character.to_number()}};
+  template <typename T>
+  [[nodiscard]] auto to_budget(unsigned option) -> std::optional<T> {
+    return option == 0 ? std::nullopt : std::optional<T>{T{option}};
   }
 
-  [[nodiscard]] auto reference_call(Referencer& referencer,  // NOLINT(*recursion*)
-                                    Reference const& reference) -> Reference_graph {
-    switch (reference.kind) {
-      using enum SymbolKind;
-      case Constructor:
-      case Function:
-      case Interface:
-      case Method:
-      case Operator:
-        return to_graph(referencer.find_caller_hierarchies(reference), Edge_type::dashed, /*reverse_edge=*/true);
-
-      case Array:
-      case Boolean:
-      case Class:
-      case Constant:
-      case Enum:
-      case EnumMember:
-      case Event:
-      case Field:
-      case File:
-      case Key:
-      case Module:
-      case Namespace:
-      case Null:
-      case Number:
-      case Object:
-      case Package:
-      case Property:
-      case String:
-      case Struct:
-      case TypeParameter:
-      case Variable:
-        return {};
-    }
-    return {};  // FIXME: unreachable
+  [[nodiscard]] auto resolved_jobs() -> std::size_t {
+    return option::jobs == 0 ? std::max(std::thread::hardware_concurrency(), 1U) : option::jobs;
   }
 
-  [[nodiscard]] auto reference_supertype(Referencer& referencer,  // NOLINT(*recursion*)
-                                         Reference const& reference) -> Reference_graph {
-    switch (reference.kind) {
-      using enum SymbolKind;
-      case Class:
-      case Enum:
-      case Struct:
-        return to_graph(referencer.find_supertype_hierarchies(reference), Edge_type::dashed, /*reverse_edge=*/true);
-
-      case Array:
-      case Boolean:
-      case Constant:
-      case Constructor:
-      case EnumMember:
-      case Event:
-      case Field:
-      case File:
-      case Function:
-      case Interface:
-      case Key:
-      case Method:
-      case Module:
-      case Namespace:
-      case Null:
-      case Number:
-      case Object:
-      case Operator:
-      case Package:
-      case Property:
-      case String:
-      case TypeParameter:
-      case Variable:
-        return {};
+  [[nodiscard]] auto command_line_queries() -> Queries {
+    Queries result{.files{option::file.begin(), option::file.end()},
+                   .locations{option::location.begin(), option::location.end()},
+                   .names{option::name.begin(), option::name.end()},
+                   .names_fuzzy{option::name_fuzzy.begin(), option::name_fuzzy.end()},
+                   .diffs{option::diff.begin(), option::diff.end()},
+                   .old_indexes{option::old_index.begin(), option::old_index.end()}};
+    if (!option::queries.empty()) {
+      append(result, read_queries(option::queries));
     }
-    return {};  // FIXME: unreachable
+    return result;
   }
 
-  [[nodiscard]] auto reference_subtype(Referencer& referencer,  // NOLINT(*recursion*)
-                                       Reference const& reference) -> Reference_graph {
-    switch (reference.kind) {
-      using enum SymbolKind;
-      case Class:
-      case Enum:
-      case Struct:
-        return to_graph(referencer.find_subtype_hierarchies(reference), Edge_type::dashed, /*reverse_edge=*/false);
-
-      case Array:
-      case Boolean:
-      case Constant:
-      case Constructor:
-      case EnumMember:
-      case Event:
-      case Field:
-      case File:
-      case Function:
-      case Interface:
-      case Key:
-      case Method:
-      case Module:
-      case Namespace:
-      case Null:
-      case Number:
-      case Object:
-      case Operator:
-      case Package:
-      case Property:
-      case String:
-      case TypeParameter:
-      case Variable:
-        return {};
-    }
-    return {};  // FIXME: unreachable
+  [[nodiscard]] auto impact_options() -> Impact_options {
+    return Impact_options{.follow_contain_by{option::follow_contain_by},
+                          .follow_call{option::follow_call},
+                          .follow_supertype{option::follow_supertype},
+                          .follow_subtype{option::follow_subtype},
+                          .index_file{existing_absolute(option::index_file)}};
   }
 
-  [[nodiscard]] auto reference_on_option(Referencer& referencer, Reference const& reference) -> Reference_graph {
-    Reference_graph result{to_graph(referencer.find_references(reference), Edge_type::solid, /*reverse_edge=*/false)};
-    if (option::follow_contain_by) {
-      auto path{referencer.find_container_path(reference)};
-      merge_by(result, to_graph(path, Edge_type::dashed, true));
-
-      if (option::follow_call || option::follow_subtype || option::follow_supertype) {
-        visit(path, [&](Reference const& node) {
-          if (option::follow_call) {
-            merge_by(result, reference_call(referencer, node));
-          }
-          if (option::follow_supertype) {
-            merge_by(result, reference_supertype(referencer, node));
-          }
-          if (option::follow_subtype) {
-            merge_by(result, reference_subtype(referencer, node));
-          }
-        });
+  // Merges pairs of graphs concurrently until one is left, so that merging costs log(n) rounds rather than n
+  [[nodiscard]] auto merge_in_parallel(std::vector<Reference_graph_builder> graphs) -> Reference_graph {
+    if (graphs.empty()) {
+      return {};
+    }
+
+    while (graphs.size() > 1) {
+      std::vector<std::future<void>> merged;
+      for (std::size_t i{0}; i + 1 < graphs.size(); i += 2) {
+        merged.push_back(std::async(std::launch::async,
+                                    [&lhs{graphs[i]}, &rhs{graphs[i + 1]}] { lhs.merge(rhs.graph()); }));
+      }
+      for (auto& future : merged) {
+        future.get();
       }
+
+      std::vector<Reference_graph_builder> next;
+      next.reserve((graphs.size() + 1) / 2);
+      for (std::size_t i{0}; i < graphs.size(); i += 2) {
+        next.push_back(std::move(graphs[i]));
+      }
+      graphs = std::move(next);
     }
-    return result;
+    return std::move(graphs.front()).build();
   }
 
-  [[nodiscard]] auto impact_file(Referencer& referencer, llvm::StringRef file) -> Reference_graph {
-    Reference_graph result{};
-    auto root{referencer.query_file(file)};
-    merge_by(result, to_graph(root, Edge_type::solid, /*reverse_edge=*/false));
-    for (auto& child : root.children) {
-      visit(child, [&](Reference const& reference) { merge_by(result, reference_on_option(referencer, reference)); });
+  [[nodiscard]] auto build_graph(Referencer& referencer, std::vector<Seed> const& seeds) -> Reference_graph {
+    std::size_t const jobs{std::min<std::size_t>(resolved_jobs(), std::max<std::size_t>(seeds.size(), 1))};
+    if (jobs == 1) {
+      Reference_graph_builder result;
+      for (auto const& seed : seeds) {
+        seed(referencer, result);
+      }
+      return std::move(result).build();
     }
+
+    // Each worker pulls the next seed and merges it into its own graph, the referencer and its clangd server are
+    // shared so that they are queried concurrently while their caches are reused across seeds
+    std::atomic<std::size_t> next_seed{0};
+    std::vector<std::future<Reference_graph_builder>> workers;
+    workers.reserve(jobs);
+    for (std::size_t i{0}; i < jobs; ++i) {
+      workers.push_back(std::async(std::launch::async, [&seeds, &next_seed, &referencer] {
+        Reference_graph_builder result;
+        for (std::size_t seed{next_seed++}; seed < seeds.size(); seed = next_seed++) {
+          seeds[seed](referencer, result);
+        }
+        return result;
+      }));
+    }
+
+    std::vector<Reference_graph_builder> graphs;
+    graphs.reserve(jobs);
+    for (auto& worker : workers) {
+      graphs.push_back(worker.get());
+    }
+    return merge_in_parallel(std::move(graphs));
+  }
+
+  // Files are truncated if any of their symbols is, by `Vertex_traits<Reference>::collapse`
+  [[nodiscard]] auto to_file_level(Reference const& reference) -> Reference {
+    auto result{make_file_reference(reference.uri)};
+    result.truncated = reference.truncated;
     return result;
   }
 
-  [[nodiscard]] auto impact_location(Referencer& referencer,
-                                     llvm::StringRef file,
-                                     clang::clangd::Position pos) -> Reference_graph {
-    Reference_graph result{};
+  [[nodiscard]] auto adjust_graph(Referencer& /*referencer*/, Frozen_reference_graph graph) -> Frozen_reference_graph {
+    if (option::file_level) {
+      return parallel_map(graph, to_file_level, resolved_jobs());
+    }
+    return graph;
+  }
 
-    auto queried{referencer.query_location(file, pos)};
-    if (!queried) {
-      throw std::invalid_argument{fmt::format("No symbol found in {}:{}:{}", file.data(), pos.line, pos.character)};
+  // Passes what one worker's walks add on to the shared `output`, adjusted vertex by vertex. The worker's own builder
+  // numbers its vertices, which are mapped to the ids `output` gives them.
+  class [[nodiscard]] Forwarding_sink final : public Graph_sink<Reference, Edge_type> {
+   public:
+    Forwarding_sink(Reference_graph_builder& output, std::mutex& mutex) : output_{&output}, mutex_{&mutex} {}
+
+    void add_vertex(graaf::vertex_id_t id, Reference const& vertex) override {
+      std::scoped_lock const lock{*mutex_};
+      auto const output_id{output_->add_vertex(option::file_level ? to_file_level(vertex) : vertex)};
+      if (ids_.size() <= id) {
+        ids_.resize(id + 1);
+      }
+      ids_[id] = output_id;
     }
 
-    merge_by(result, reference_on_option(referencer, *queried));
+    // Edges within one file are dropped at file level, as `map` does
+    void add_edge(graaf::vertex_id_t source, graaf::vertex_id_t target, Edge_type const& edge) override {
+      if (ids_[source] == ids_[target]) {
+        return;
+      }
+      std::scoped_lock const lock{*mutex_};
+      output_->add_edge(ids_[source], ids_[target], edge);
+    }
 
-    return result;
-  }
+   private:
+    Reference_graph_builder* output_;
+    std::mutex* mutex_;
+    std::vector<graaf::vertex_id_t> ids_;
+  };
+
+  // Vertices are passed on to `sink` while the walks run, as soon as they are final, and the output is flushed after
+  // each seed. Only the distinct vertices and edges sent so far are remembered, so memory still grows with the output
+  // but not with formatted labels or a whole graph. A vertex is written as its first copy is, so a symbol that a later
+  // walk expands or truncates, or a file with a truncated symbol found later, keeps the mark it was written with.
+  void stream_graph(Referencer& referencer,
+                    std::vector<Seed> const& seeds,
+                    Graph_sink<Reference, Edge_type>& sink,
+                    std::ostream& ostream) {
+    Reference_graph_builder result{sink};
+    std::mutex mutex;
+    std::atomic<std::size_t> next_seed{0};
+    auto const run_seeds{[&] {
+      Forwarding_sink forwarding{result, mutex};
+      Reference_graph_builder graph{forwarding};
+      for (std::size_t seed{next_seed++}; seed < seeds.size(); seed = next_seed++) {
+        seeds[seed](referencer, graph);
+        std::scoped_lock const lock{mutex};
+        ostream.flush();
+      }
+    }};
 
-  [[nodiscard]] auto impact_name(Referencer& referencer, llvm::StringRef name, bool fuzzy) -> Reference_graph {
-    Reference_graph result{};
+    std::size_t const jobs{std::min<std::size_t>(resolved_jobs(), std::max<std::size_t>(seeds.size(), 1))};
+    if (jobs == 1) {
+      run_seeds();
+      return;
+    }
 
-    auto querieds{referencer.query_name(name, fuzzy)};
-    for (auto& queried : querieds) {
-      merge_by(result, reference_on_option(referencer, queried));
+    std::vector<std::future<void>> workers;
+    workers.reserve(jobs);
+    for (std::size_t i{0}; i < jobs; ++i) {
+      workers.push_back(std::async(std::launch::async, [&run_seeds] { run_seeds(); }));
     }
+    for (auto& worker : workers) {
+      worker.get();
+    }
+  }
 
-    return result;
+  // The graph is only read from now on
+  [[nodiscard]] auto build_frozen_graph(Referencer& referencer, std::vector<Seed> const& seeds)
+      -> Frozen_reference_graph {
+    return adjust_graph(referencer, freeze(build_graph(referencer, seeds)));
   }
 
-  [[nodiscard]] auto build_graph(Referencer& referencer) -> Reference_graph {
-    Reference_graph result;
+  void write_graph(Referencer& referencer,
+                   std::vector<Seed> const& seeds,
+                   Graph_sink<Reference, Edge_type>& sink,
+                   std::ostream& ostream) {
+    if (option::stream) {
+      stream_graph(referencer, seeds, sink, ostream);
+      return;
+    }
+    send_to(sink, build_frozen_graph(referencer, seeds));
+  }
 
-    for (auto const& file : option::file) {
-      merge_by(result, impact_file(referencer, existing_absolute(file)));
+  // Digest of the queries and of every input and option the graph they make depends on, except for the contents of
+  // the files involved, which `Result_cache` checks against the graph itself
+  [[nodiscard]] auto result_key(Queries const& queries) -> std::string {
+    Cache_key key;
+    key.add(fmt::format("cppcia {} graph {}", CPPCIA_VERSION, detail::binary::version));
+    key.add_file(existing_absolute(option::index_file));
+    auto const compile_commands_dir{std::filesystem::path{existing_absolute(option::compile_commands_dir)}};
+    key.add_file(compile_commands_dir / "compile_commands.json");
+    key.add_file(compile_commands_dir / "compile_flags.txt");
+    key.add(option::resource_dir);
+    for (auto const& glob : option::query_driver_globs) {
+      key.add(glob);
     }
 
-    for (auto const& location : option::location) {
+    std::vector<std::string> files;
+    for (auto const& file : queries.files) {
+      files.push_back(canonical_file(file));
+    }
+    std::vector<std::string> locations;
+    for (auto const& location : queries.locations) {
       auto [file, pos]{parse_location(location)};
-      merge_by(result, impact_location(referencer, existing_absolute(file), pos));
+      locations.push_back(fmt::format("{}:{}:{}", canonical_file(file), pos.line, pos.character));
     }
-
-    for (auto const& name : option::name) {
-      merge_by(result, impact_name(referencer, name, false));
+    std::vector<std::string> diffs;
+    for (auto const& diff : queries.diffs) {
+      diffs.push_back(canonical_file(diff));
+    }
+    std::vector<std::string> old_indexes;
+    for (auto const& old_index : queries.old_indexes) {
+      old_indexes.push_back(canonical_file(old_index));
     }
+    auto const add_all{[&key](std::string_view kind, std::vector<std::string> const& values) {
+      key.add(kind);
+      for (auto const& value : values) {
+        key.add(value);
+      }
+    }};
+    add_all("file", sorted_unique(files));
+    add_all("location", sorted_unique(locations));
+    add_all("name", sorted_unique(queries.names));
+    add_all("name-fuzzy", sorted_unique(queries.names_fuzzy));
+    // Only the contents of these matter, wherever they are
+    auto const add_all_files{[&key](std::string_view kind, std::vector<std::string> const& files) {
+      key.add(kind);
+      for (auto const& file : files) {
+        key.add_file(file);
+      }
+    }};
+    add_all_files("diff", sorted_unique(diffs));
+    add_all_files("old-index", sorted_unique(old_indexes));
+
+    key.add(fmt::format("follow {:d} {:d} {:d} {:d}",
+                        option::follow_contain_by.getValue(),
+                        option::follow_call.getValue(),
+                        option::follow_supertype.getValue(),
+                        option::follow_subtype.getValue()));
+    key.add(fmt::format("index-only {:d}", option::index_only.getValue()));
+    key.add(fmt::format("file-level {:d}", option::file_level.getValue()));
+    key.add(fmt::format("budgets {} {} {}",
+                        option::max_depth.getValue(),
+                        option::max_vertices.getValue(),
+                        option::timeout.getValue()));
+    return std::move(key).digest();
+  }
 
-    for (auto const& name : option::name_fuzzy) {
-      merge_by(result, impact_name(referencer, name, true));
+  // Walks cut short by --timeout depend on how fast the machine answered, so a graph with truncated vertices would
+  // be read back the same on a later run that had time to expand them. Depth and vertex limits are in the key.
+  [[nodiscard]] auto cacheable(Frozen_reference_graph const& graph) -> bool {
+    return option::timeout == 0
+           || ranges::none_of(graph.vertices(), [](Reference const& vertex) { return vertex.truncated; });
+  }
+
+  // Files whose contents the graph depends on: the queried and diffed ones and the ones of its vertices
+  [[nodiscard]] auto result_sources(Queries const& queries, Frozen_reference_graph const& graph)
+      -> std::vector<std::string> {
+    std::vector<std::string> result;
+    for (auto const& file : queries.files) {
+      result.push_back(canonical_file(file));
+    }
+    for (auto const& location : queries.locations) {
+      result.push_back(canonical_file(parse_location(location).first));
+    }
+    // Lines of a diffed file that no symbol covered yet may cover one once the file changes
+    for (auto const& diff : queries.diffs) {
+      for (auto const& file_diff : parse_unified_diff(read_file(existing_absolute(diff)))) {
+        result.push_back(canonical_file(file_diff.file));
+      }
+    }
+    for (auto const& reference : graph.vertices()) {
+      result.push_back(reference.uri.file().str());
     }
+    return sorted_unique(std::move(result));
+  }
 
-    return result;
+  [[nodiscard]] auto output_mode() -> std::ios::openmode {
+    return option::format == Output_format::binary ? std::ios::out | std::ios::binary : std::ios::out;
   }
 
-  [[nodiscard]] auto adjust_graph(Referencer& /*referencer*/, Reference_graph graph) -> Reference_graph {
-    if (option::file_level) {
-      return map(graph, [](Reference const& reference) { return make_file_reference(reference.uri.file()); });
+  // Writes the graph `send` sends to a sink in the chosen text format
+  void write_text(std::ostream& ostream,
+                  std::optional<std::filesystem::path> const& workspace_root,
+                  llvm::function_ref<void(Graph_sink<Reference, Edge_type>&)> send) {
+    if (option::format == Output_format::dot) {
+      Dot_sink<Reference, Edge_type, Reference_writer, decltype(edge_type_writer)> sink{
+          ostream, Reference_writer{workspace_root}, edge_type_writer};
+      send(sink);
+      sink.finish();
+      return;
     }
-    return graph;
+    Json_sink<Reference, Edge_type, Reference_json_writer, decltype(edge_type_json_writer)> sink{
+        ostream,
+        option::format == Output_format::json ? Json_style::array : Json_style::lines,
+        Reference_json_writer{workspace_root},
+        edge_type_json_writer};
+    send(sink);
+    sink.finish();
   }
 }  // namespace
 
@@ -351,21 +539,79 @@ namespace {
   if (option::follow_call || option::follow_subtype || option::follow_supertype) {
     option::follow_contain_by = true;
   }
+  if (!option::serve && option::output_file.empty()) {
+    throw std::invalid_argument{"<output_file> is required unless serving"};
+  }
+  if (option::stream && option::format == Output_format::binary) {
+    throw std::invalid_argument{"--stream can't be used with --format=binary, whose layout needs the whole graph"};
+  }
+
+  std::optional<std::filesystem::path> const workspace_root{
+      option::workspace_root.empty() ? std::optional<std::filesystem::path>{std::nullopt}
+                                     : std::optional<std::filesystem::path>{absolute(option::workspace_root)}};
+
+  // A cached graph is written out as it is, so the key is the only part of a warm run that reads the inputs
+  std::optional<Result_cache> const cache{option::cache_dir.empty() || option::serve || option::stream
+                                              ? std::optional<Result_cache>{std::nullopt}
+                                              : std::optional<Result_cache>{absolute(option::cache_dir)}};
+  Queries const queries{option::serve ? Queries{} : command_line_queries()};
+  std::string const key{cache ? result_key(queries) : ""};
+  if (cache) {
+    if (auto const cached{cache->lookup(key)}) {
+      std::ofstream ofile{absolute(option::output_file), output_mode()};
+      if (option::format == Output_format::binary) {
+        ofile << std::ifstream{cache->graph_file(key), std::ios::in | std::ios::binary}.rdbuf();
+      } else {
+        write_text(ofile, workspace_root, [&cached](Graph_sink<Reference, Edge_type>& sink) {
+          send_to(sink, *cached);
+        });
+      }
+      return 0;
+    }
+  }
 
   Referencer referencer{make_extractor(existing_absolute(option::index_file),
                                        existing_absolute(option::compile_commands_dir),
                                        option::resource_dir.empty() ? "" : existing_absolute(option::resource_dir),
-                                       std::move(option::query_driver_globs))};
-
-  Reference_graph graph{adjust_graph(referencer, build_graph(referencer))};
+                                       std::move(option::query_driver_globs)),
+                        /*for_test=*/false,
+                        Referencer_options{
+                            .index_only{option::index_only},
+                            .max_depth{to_budget<std::size_t>(option::max_depth)},
+                            .max_vertices{to_budget<std::size_t>(option::max_vertices)},
+                            .timeout{to_budget<std::chrono::milliseconds>(option::timeout)},
+                        }};
+
+  if (option::serve) {
+    // Requests are served one at a time, while each impact query still resolves its seeds with `-j` jobs
+    Server{referencer,
+           [&referencer](nlohmann::json const& params) {
+             return build_frozen_graph(referencer, collect_seeds(json_queries(params), impact_options()));
+           },
+           workspace_root}
+        .serve(std::cin, std::cout);
+    return 0;
+  }
 
-  std::ofstream ofile{absolute(option::output_file)};
-  format_to_in_dot(ofile,
-                   graph,
-                   Reference_writer{option::workspace_root.empty()
-                                        ? std::optional<std::filesystem::path>{std::nullopt}
-                                        : std::optional<std::filesystem::path>{absolute(option::workspace_root)}},
-                   edge_type_writer);
+  std::vector<Seed> const seeds{collect_seeds(queries, impact_options())};
+  std::ofstream ofile{absolute(option::output_file), output_mode()};
+  if (cache) {
+    auto const graph{build_frozen_graph(referencer, seeds)};
+    if (cacheable(graph)) {
+      cache->store(key, graph, result_sources(queries, graph));
+    }
+    if (option::format == Output_format::binary) {
+      write_binary(ofile, graph);
+    } else {
+      write_text(ofile, workspace_root, [&graph](Graph_sink<Reference, Edge_type>& sink) { send_to(sink, graph); });
+    }
+  } else if (option::format == Output_format::binary) {
+    write_binary(ofile, build_frozen_graph(referencer, seeds));
+  } else {
+    write_text(ofile, workspace_root, [&](Graph_sink<Reference, Edge_type>& sink) {
+      write_graph(referencer, seeds, sink, ofile);
+    });
+  }
 
   return 0;
 }
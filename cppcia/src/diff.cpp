@@ -0,0 +1,122 @@
+#include "cppcia/diff.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <ctre.hpp>
+#include <fmt/core.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+
+namespace cppcia {
+namespace {
+  [[nodiscard]] auto new_file_of(llvm::StringRef header) -> std::optional<std::string> {
+    auto file{header.drop_front(llvm::StringRef{"+++ "}.size()).split('\t').first.rtrim()};
+    if (file == "/dev/null") {
+      return std::nullopt;
+    }
+    file.consume_front("b/");
+    return file.str();
+  }
+
+  struct Hunk_header {
+   public:
+    // NOLINTBEGIN(*non-private-member*)
+    int old_count;
+    int new_start;  // counted from 1
+    int new_count;
+    // NOLINTEND(*non-private-member*)
+  };
+
+  // A header like `@@ -1,2 +3,4 @@`, where omitted counts are 1
+  [[nodiscard]] auto parse_hunk_header(llvm::StringRef header) -> Hunk_header {
+    auto [whole, old_count, new_start, new_count]{
+        ctre::search<R"ctre(^@@ -\d+(?:,(\d+))? \+(\d+)(?:,(\d+))? @@)ctre">(std::string_view{header})};
+    if (!whole) {
+      throw std::invalid_argument{fmt::format("{} is not a valid hunk header", header.str())};
+    }
+    return Hunk_header{.old_count{old_count ? old_count.to_number() : 1},
+                       .new_start{new_start.to_number()},
+                       .new_count{new_count ? new_count.to_number() : 1}};
+  }
+
+  void add_line(File_diff& diff, int line) {
+    if (!diff.changed_lines.empty() && diff.changed_lines.back().last + 1 >= line) {
+      diff.changed_lines.back().last = std::max(diff.changed_lines.back().last, line);
+      return;
+    }
+    diff.changed_lines.push_back(Line_range{.first{line}, .last{line}});
+  }
+}  // namespace
+
+auto merged(std::vector<Line_range> ranges) -> std::vector<Line_range> {
+  std::sort(ranges.begin(), ranges.end(), [](Line_range const& lhs, Line_range const& rhs) {
+    return lhs.first < rhs.first;
+  });
+  std::vector<Line_range> result;
+  for (auto const& range : ranges) {
+    if (!result.empty() && result.back().last + 1 >= range.first) {
+      result.back().last = std::max(result.back().last, range.last);
+    } else {
+      result.push_back(range);
+    }
+  }
+  return result;
+}
+
+auto intersects(std::span<Line_range const> ranges, int first, int last) -> bool {
+  auto const iter{std::partition_point(
+      ranges.begin(), ranges.end(), [first](Line_range const& range) { return range.last < first; })};
+  return iter != ranges.end() && iter->first <= last;
+}
+
+auto parse_unified_diff(llvm::StringRef diff) -> std::vector<File_diff> {
+  std::vector<File_diff> result;
+
+  llvm::SmallVector<llvm::StringRef> lines;
+  diff.split(lines, '\n');
+
+  File_diff* current{nullptr};
+  int new_line{0};  // the next line of the new version, counted from 0
+  int old_left{0};  // lines of the current hunk left to read in the old and the new version
+  int new_left{0};
+  for (auto line : lines) {
+    line = line.rtrim('\r');
+    if (old_left > 0 || new_left > 0) {
+      if (line.starts_with("+")) {
+        add_line(*current, new_line);
+        ++new_line;
+        --new_left;
+      } else if (line.starts_with("-")) {
+        add_line(*current, std::max(new_line, 0));
+        --old_left;
+      } else if (!line.starts_with("\\")) {  // `\ No newline at end of file` belongs to the line before
+        ++new_line;
+        --old_left;
+        --new_left;
+      }
+    } else if (line.starts_with("+++ ")) {
+      auto file{new_file_of(line)};
+      current = file ? &result.emplace_back(File_diff{.file{std::move(*file)}, .changed_lines{}}) : nullptr;
+    } else if (line.starts_with("@@") && current != nullptr) {
+      auto const header{parse_hunk_header(line)};
+      new_line = header.new_start - 1;
+      old_left = header.old_count;
+      new_left = header.new_count;
+    }
+  }
+
+  // Hunks are usually in order already, but nothing in the format requires it
+  for (auto& file_diff : result) {
+    file_diff.changed_lines = merged(std::move(file_diff.changed_lines));
+  }
+  std::erase_if(result, [](File_diff const& file_diff) { return file_diff.changed_lines.empty(); });
+  return result;
+}
+}  // namespace cppcia
\ No newline at end of file
@@ -1,17 +1,24 @@
 #include "cppcia/extractor.hpp"
 
 #include <concepts>
+#include <cstddef>
+#include <filesystem>
 #include <fstream>
 #include <functional>
+#include <gsl/gsl>
 #include <iostream>
+#include <latch>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <system_error>
 #include <utility>
 #include <vector>
 
 #include <clangd/ClangdServer.h>
+#include <clangd/FindSymbols.h>
 #include <clangd/GlobalCompilationDatabase.h>
 #include <clangd/Hover.h>
 #include <clangd/Protocol.h>
@@ -20,14 +27,23 @@
 #include <clangd/XRefs.h>
 #include <clangd/index/Index.h>
 #include <clangd/index/MemIndex.h>
+#include <clangd/index/Ref.h>
+#include <clangd/index/Relation.h>
 #include <clangd/index/Serialization.h>
+#include <clangd/index/Symbol.h>
+#include <clangd/index/SymbolID.h>
 #include <clangd/index/SymbolOrigin.h>
+#include <clangd/index/dex/Dex.h>
+#include <clangd/support/Function.h>
 #include <clangd/support/Logger.h>
 #include <clangd/support/Path.h>
 #include <clangd/support/Threading.h>
 #include <clangd/support/ThreadsafeFS.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
 #include <llvm/ADT/StringRef.h>
 #include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBuffer.h>
 #include <range/v3/all.hpp>
 
 namespace cppcia {
@@ -45,24 +61,101 @@ namespace {
     };
   }
 
+  template <typename T>
+  [[nodiscard]] auto make_counted_callback(std::latch& done, std::invocable<T&> auto function) -> auto {
+    return [&done, function{std::move(function)}](llvm::Expected<T> expected) mutable {
+      if (expected) {
+        std::invoke(std::move(function), *expected);
+      } else {
+        clang::clangd::elog("{0}", llvm::toString(expected.takeError()));
+      }
+      done.count_down();
+    };
+  }
+
+  [[nodiscard]] auto modification_time_of(clang::clangd::PathRef file)
+      -> std::optional<std::filesystem::file_time_type> {
+    std::error_code error{};
+    std::filesystem::file_time_type modification_time{std::filesystem::last_write_time(file.str(), error)};
+    return error ? std::nullopt : std::optional<std::filesystem::file_time_type>{modification_time};
+  }
+
+  // Sends one request per input at once and waits for all of them, so that clangd can serve them in its worker pool
+  template <typename T, typename Input>
+  [[nodiscard]] auto send_all_and_wait(std::vector<Input> const& inputs,
+                                       std::invocable<Input const&, clang::clangd::Callback<T>> auto send)
+      -> std::vector<T> {
+    std::vector<T> result(inputs.size());
+
+    std::latch done{gsl::narrow_cast<std::ptrdiff_t>(inputs.size())};
+    for (std::size_t i{0}; i < inputs.size(); ++i) {
+      std::invoke(send, inputs[i], make_counted_callback<T>(done, [&result, i](T& value) {
+                    result[i] = std::move(value);
+                  }));
+    }
+    done.wait();
+
+    return result;
+  }
+
   void append_range(auto& container, auto&& range) {
     for (auto& value : range) {
       container.emplace_back(value);
     }
   }
+
+  template <typename T>
+  [[nodiscard]] auto join(std::vector<std::vector<T>> ranges) -> std::vector<T> {
+    std::vector<T> result;
+    for (auto& range : ranges) {
+      append_range(result, std::move(range));
+    }
+    return result;
+  }
 }  // namespace
 
 Extractor::Extractor(std::unique_ptr<clang::clangd::GlobalCompilationDatabase> cdb,
                      std::unique_ptr<clang::clangd::ThreadsafeFS> tfs,
                      clang::clangd::ClangdServer::Options options,
-                     std::unique_ptr<clang::clangd::SymbolIndex> symbol_index)
-    : cdb_{std::move(cdb)}, tfs_{std::move(tfs)}, symbol_index_{std::move(symbol_index)} {
+                     std::unique_ptr<clang::clangd::SymbolIndex> symbol_index,
+                     Base_map bases)
+    : cdb_{std::move(cdb)}, tfs_{std::move(tfs)}, symbol_index_{std::move(symbol_index)}, bases_{std::move(bases)} {
   options.StaticIndex = symbol_index_.get();
   server_             = std::make_unique<clang::clangd::ClangdServer>(*cdb_, *tfs_, std::move(options));
 }
 
-void Extractor::update_file(clang::clangd::PathRef file, llvm::StringRef content) {
+auto Extractor::update_file(clang::clangd::PathRef file, llvm::StringRef content) -> bool {
+  return update_file(file, content, modification_time_of(file));
+}
+
+auto Extractor::update_file(clang::clangd::PathRef file) -> bool {
+  auto const modification_time{modification_time_of(file)};
+  if (modification_time) {
+    std::scoped_lock const lock{*mutex_};
+    if (auto iter{documents_.find(file)};
+        iter != documents_.end() && iter->second.modification_time == modification_time) {
+      return false;
+    }
+  }
+  return update_file(file, read_file(file), modification_time);
+}
+
+auto Extractor::update_file(clang::clangd::PathRef file,
+                            llvm::StringRef content,
+                            std::optional<std::filesystem::file_time_type> modification_time) -> bool {
+  auto digest{clang::clangd::digest(content)};
+
+  std::scoped_lock const lock{*mutex_};
+  auto [iter, inserted]{
+      documents_.try_emplace(file, Document{.digest{digest}, .modification_time{modification_time}})};
+  iter->second.modification_time = modification_time;
+  if (!inserted && iter->second.digest == digest) {
+    return false;
+  }
+  iter->second.digest = digest;
+
   server_->addDocument(file, content, "null", clang::clangd::WantDiagnostics::No, false);
+  return true;
 }
 
 [[nodiscard]] auto Extractor::query_file(llvm::StringRef file) -> std::vector<clang::clangd::DocumentSymbol> {
@@ -70,10 +163,12 @@ void Extractor::update_file(clang::clangd::PathRef file, llvm::StringRef content
 
   {
     clang::clangd::Notification done;
+    std::unique_lock lock{*mutex_};
     server_->documentSymbols(
         file,
         make_expectedless_callback<std::vector<clang::clangd::DocumentSymbol>>(
             done, [&result](std::vector<clang::clangd::DocumentSymbol>& symbols) { result = std::move(symbols); }));
+    lock.unlock();
     done.wait();
   }
 
@@ -86,11 +181,13 @@ void Extractor::update_file(clang::clangd::PathRef file, llvm::StringRef content
 
   {
     clang::clangd::Notification done;
+    std::unique_lock lock{*mutex_};
     server_->locateSymbolAt(
         file,
         pos,
         make_expectedless_callback<std::vector<clang::clangd::LocatedSymbol>>(
             done, [&result](std::vector<clang::clangd::LocatedSymbol>& info) { result = std::move(info); }));
+    lock.unlock();
     done.wait();
   }
 
@@ -103,17 +200,29 @@ void Extractor::update_file(clang::clangd::PathRef file, llvm::StringRef content
 
   {
     clang::clangd::Notification done;
+    std::unique_lock lock{*mutex_};
     server_->findHover(
         file,
         pos,
         make_expectedless_callback<std::optional<clang::clangd::HoverInfo>>(
             done, [&result](std::optional<clang::clangd::HoverInfo>& info) { result = std::move(info); }));
+    lock.unlock();
     done.wait();
   }
 
   return result;
 }
 
+[[nodiscard]] auto Extractor::query_location_infos(std::vector<File_position> const& positions)
+    -> std::vector<std::optional<clang::clangd::HoverInfo>> {
+  return send_all_and_wait<std::optional<clang::clangd::HoverInfo>>(
+      positions,
+      [this](File_position const& position, clang::clangd::Callback<std::optional<clang::clangd::HoverInfo>> callback) {
+        std::scoped_lock const lock{*mutex_};
+        server_->findHover(position.first, position.second, std::move(callback));
+      });
+}
+
 [[nodiscard]] auto Extractor::query_name(llvm::StringRef name,
                                          bool fuzzy) -> std::vector<clang::clangd::SymbolInformation> {
   auto [_, unqualified_name]{clang::clangd::splitQualifiedName(name)};
@@ -122,6 +231,7 @@ void Extractor::update_file(clang::clangd::PathRef file, llvm::StringRef content
 
   {
     clang::clangd::Notification done;
+    std::unique_lock lock{*mutex_};
     server_->workspaceSymbols(
         name,
         0,
@@ -135,6 +245,7 @@ void Extractor::update_file(clang::clangd::PathRef file, llvm::StringRef content
                                      }));
               }
             }));
+    lock.unlock();
     done.wait();
   }
 
@@ -147,11 +258,13 @@ void Extractor::update_file(clang::clangd::PathRef file, llvm::StringRef content
 
   {
     clang::clangd::Notification done;
+    std::unique_lock lock{*mutex_};
     server_->findType(
         file,
         pos,
         make_expectedless_callback<std::vector<clang::clangd::LocatedSymbol>>(
             done, [&result](std::vector<clang::clangd::LocatedSymbol>& symbols) { result = std::move(symbols); }));
+    lock.unlock();
     done.wait();
   }
 
@@ -164,29 +277,180 @@ void Extractor::update_file(clang::clangd::PathRef file, llvm::StringRef content
 
   {
     clang::clangd::Notification done;
+    std::unique_lock lock{*mutex_};
     server_->findReferences(file,
                             pos,
                             0,
                             false,
                             make_expectedless_callback<clang::clangd::ReferencesResult>(
                                 done, [&result](clang::clangd::ReferencesResult& refs) { result = std::move(refs); }));
+    lock.unlock();
     done.wait();
   }
 
   return result;
 }
 
+[[nodiscard]] auto Extractor::find_index_references(clang::clangd::SymbolID const& id)
+    -> std::vector<clang::clangd::Location> {
+  std::vector<clang::clangd::Location> result;
+  if (!symbol_index_) {
+    return result;
+  }
+
+  clang::clangd::RefsRequest request{};
+  request.IDs.insert(id);
+  symbol_index_->refs(request, [&result](clang::clangd::Ref const& ref) {
+    auto location{clang::clangd::indexToLSPLocation(ref.Location, "")};
+    if (!location) {
+      clang::clangd::elog("{0}", llvm::toString(location.takeError()));
+      return;
+    }
+    result.emplace_back(std::move(*location));
+  });
+
+  return result;
+}
+
+[[nodiscard]] auto Extractor::lookup_index_symbols(std::vector<clang::clangd::SymbolID> const& ids)
+    -> std::vector<clang::clangd::Symbol> {
+  std::vector<clang::clangd::Symbol> result;
+  if (!symbol_index_) {
+    return result;
+  }
+
+  clang::clangd::LookupRequest request{};
+  request.IDs.insert(ids.begin(), ids.end());
+  symbol_index_->lookup(request, [&result](clang::clangd::Symbol const& symbol) { result.emplace_back(symbol); });
+
+  return result;
+}
+
+[[nodiscard]] auto Extractor::query_index_name(llvm::StringRef scope,
+                                               llvm::StringRef name) -> std::vector<clang::clangd::Symbol> {
+  std::vector<clang::clangd::Symbol> result;
+  if (!symbol_index_) {
+    return result;
+  }
+
+  clang::clangd::FuzzyFindRequest request{};
+  request.Query  = name.str();
+  request.Scopes = {scope.str()};
+  symbol_index_->fuzzyFind(request, [&result, name](clang::clangd::Symbol const& symbol) {
+    if (symbol.Name == name) {
+      result.emplace_back(symbol);
+    }
+  });
+
+  return result;
+}
+
+[[nodiscard]] auto Extractor::find_index_callers_per_id(std::vector<clang::clangd::SymbolID> const& ids)
+    -> std::vector<std::vector<clang::clangd::Symbol>> {
+  std::vector<std::vector<clang::clangd::Symbol>> result(ids.size());
+  if (!symbol_index_) {
+    return result;
+  }
+
+  // A refs request doesn't tell which of its ids a ref belongs to, so query them one by one
+  std::vector<std::vector<clang::clangd::SymbolID>> container_ids_per_id(ids.size());
+  clang::clangd::LookupRequest container_request{};
+  for (std::size_t i{0}; i < ids.size(); ++i) {
+    clang::clangd::RefsRequest request{};
+    request.IDs.insert(ids[i]);
+    request.Filter        = clang::clangd::RefKind::Reference;
+    request.WantContainer = true;
+
+    llvm::DenseSet<clang::clangd::SymbolID> seen;
+    symbol_index_->refs(request, [&](clang::clangd::Ref const& ref) {
+      if (ref.Container && seen.insert(ref.Container).second) {
+        container_ids_per_id[i].push_back(ref.Container);
+        container_request.IDs.insert(ref.Container);
+      }
+    });
+  }
+
+  llvm::DenseMap<clang::clangd::SymbolID, clang::clangd::Symbol> containers;
+  symbol_index_->lookup(container_request, [&containers](clang::clangd::Symbol const& symbol) {
+    containers.try_emplace(symbol.ID, symbol);
+  });
+
+  for (std::size_t i{0}; i < ids.size(); ++i) {
+    for (auto const& container_id : container_ids_per_id[i]) {
+      if (auto iter{containers.find(container_id)}; iter != containers.end()) {
+        result[i].emplace_back(iter->second);
+      }
+    }
+  }
+  return result;
+}
+
+[[nodiscard]] auto Extractor::find_index_subtypes_per_id(std::vector<clang::clangd::SymbolID> const& ids)
+    -> std::vector<std::vector<clang::clangd::Symbol>> {
+  std::vector<std::vector<clang::clangd::Symbol>> result(ids.size());
+  if (!symbol_index_) {
+    return result;
+  }
+
+  llvm::DenseMap<clang::clangd::SymbolID, std::size_t> id_to_indices;
+  clang::clangd::RelationsRequest request{};
+  for (std::size_t i{0}; i < ids.size(); ++i) {
+    id_to_indices.try_emplace(ids[i], i);
+    request.Subjects.insert(ids[i]);
+  }
+  request.Predicate = clang::clangd::RelationKind::BaseOf;
+
+  symbol_index_->relations(
+      request, [&result, &id_to_indices](clang::clangd::SymbolID const& subject, clang::clangd::Symbol const& object) {
+        result[id_to_indices.lookup(subject)].emplace_back(object);
+      });
+
+  return result;
+}
+
+[[nodiscard]] auto Extractor::find_index_supertypes_per_id(std::vector<clang::clangd::SymbolID> const& ids)
+    -> std::vector<std::vector<clang::clangd::Symbol>> {
+  std::vector<std::vector<clang::clangd::Symbol>> result(ids.size());
+  if (!symbol_index_) {
+    return result;
+  }
+
+  clang::clangd::LookupRequest request{};
+  for (auto const& id : ids) {
+    if (auto iter{bases_.find(id)}; iter != bases_.end()) {
+      request.IDs.insert(iter->second.begin(), iter->second.end());
+    }
+  }
+  llvm::DenseMap<clang::clangd::SymbolID, clang::clangd::Symbol> bases;
+  symbol_index_->lookup(request, [&bases](clang::clangd::Symbol const& symbol) {
+    bases.try_emplace(symbol.ID, symbol);
+  });
+
+  for (std::size_t i{0}; i < ids.size(); ++i) {
+    if (auto iter{bases_.find(ids[i])}; iter != bases_.end()) {
+      for (auto const& base_id : iter->second) {
+        if (auto base{bases.find(base_id)}; base != bases.end()) {
+          result[i].emplace_back(base->second);
+        }
+      }
+    }
+  }
+  return result;
+}
+
 [[nodiscard]] auto Extractor::prepare_call_hierarchy(clang::clangd::PathRef file, clang::clangd::Position pos)
     -> std::vector<clang::clangd::CallHierarchyItem> {
   std::vector<clang::clangd::CallHierarchyItem> result{};
 
   {
     clang::clangd::Notification done;
+    std::unique_lock lock{*mutex_};
     server_->prepareCallHierarchy(
         file,
         pos,
         make_expectedless_callback<std::vector<clang::clangd::CallHierarchyItem>>(
             done, [&result](std::vector<clang::clangd::CallHierarchyItem>& items) { result = std::move(items); }));
+    lock.unlock();
     done.wait();
   }
 
@@ -195,18 +459,18 @@ void Extractor::update_file(clang::clangd::PathRef file, llvm::StringRef content
 
 [[nodiscard]] auto Extractor::find_callers(std::vector<clang::clangd::CallHierarchyItem> const& items)
     -> std::vector<clang::clangd::CallHierarchyIncomingCall> {
-  std::vector<clang::clangd::CallHierarchyIncomingCall> result;
-
-  for (clang::clangd::Notification done; auto const& item : items) {
-    server_->incomingCalls(item,
-                           make_expectedless_callback<std::vector<clang::clangd::CallHierarchyIncomingCall>>(
-                               done, [&result](std::vector<clang::clangd::CallHierarchyIncomingCall>& callers) {
-                                 append_range(result, std::move(callers));
-                               }));
-    done.wait();
-  }
+  return join(find_callers_per_item(items));
+}
 
-  return result;
+[[nodiscard]] auto Extractor::find_callers_per_item(std::vector<clang::clangd::CallHierarchyItem> const& items)
+    -> std::vector<std::vector<clang::clangd::CallHierarchyIncomingCall>> {
+  return send_all_and_wait<std::vector<clang::clangd::CallHierarchyIncomingCall>>(
+      items,
+      [this](clang::clangd::CallHierarchyItem const& item,
+             clang::clangd::Callback<std::vector<clang::clangd::CallHierarchyIncomingCall>> callback) {
+        std::scoped_lock const lock{*mutex_};
+        server_->incomingCalls(item, std::move(callback));
+      });
 }
 
 [[nodiscard]] auto Extractor::prepare_type_hierarchy(clang::clangd::PathRef file, clang::clangd::Position pos)
@@ -215,6 +479,7 @@ void Extractor::update_file(clang::clangd::PathRef file, llvm::StringRef content
 
   {
     clang::clangd::Notification done;
+    std::unique_lock lock{*mutex_};
     server_->typeHierarchy(
         file,
         pos,
@@ -222,6 +487,7 @@ void Extractor::update_file(clang::clangd::PathRef file, llvm::StringRef content
         clang::clangd::TypeHierarchyDirection::Both,
         make_expectedless_callback<std::vector<clang::clangd::TypeHierarchyItem>>(
             done, [&result](std::vector<clang::clangd::TypeHierarchyItem>& items) { result = std::move(items); }));
+    lock.unlock();
     done.wait();
   }
 
@@ -230,37 +496,41 @@ void Extractor::update_file(clang::clangd::PathRef file, llvm::StringRef content
 
 [[nodiscard]] auto Extractor::find_supertypes(std::vector<clang::clangd::TypeHierarchyItem> const& items)
     -> std::vector<clang::clangd::TypeHierarchyItem> {
-  std::vector<clang::clangd::TypeHierarchyItem> result;
-
-  for (clang::clangd::Notification done; auto const& item : items) {
-    server_->superTypes(item,
-                        make_expectedless_callback<std::optional<std::vector<clang::clangd::TypeHierarchyItem>>>(
-                            done, [&result](std::optional<std::vector<clang::clangd::TypeHierarchyItem>>& parents) {
-                              if (!parents) {
-                                return;
-                              }
-                              append_range(result, std::move(*parents));
-                            }));
-    done.wait();
-  }
+  return join(find_supertypes_per_item(items));
+}
 
-  return result;
+[[nodiscard]] auto Extractor::find_supertypes_per_item(std::vector<clang::clangd::TypeHierarchyItem> const& items)
+    -> std::vector<std::vector<clang::clangd::TypeHierarchyItem>> {
+  auto parents{send_all_and_wait<std::optional<std::vector<clang::clangd::TypeHierarchyItem>>>(
+      items,
+      [this](clang::clangd::TypeHierarchyItem const& item,
+             clang::clangd::Callback<std::optional<std::vector<clang::clangd::TypeHierarchyItem>>> callback) {
+        std::scoped_lock const lock{*mutex_};
+        server_->superTypes(item, std::move(callback));
+      })};
+  // clang-format off
+  return parents
+         | ranges::views::transform([](std::optional<std::vector<clang::clangd::TypeHierarchyItem>>& value) {
+             return std::move(value).value_or(std::vector<clang::clangd::TypeHierarchyItem>{});
+           })
+         | ranges::to<std::vector>();
+  // clang-format on
 }
 
 [[nodiscard]] auto Extractor::find_subtypes(std::vector<clang::clangd::TypeHierarchyItem> const& items)
     -> std::vector<clang::clangd::TypeHierarchyItem> {
-  std::vector<clang::clangd::TypeHierarchyItem> result{};
-
-  for (clang::clangd::Notification done; auto const& item : items) {
-    server_->subTypes(item,
-                      make_expectedless_callback<std::vector<clang::clangd::TypeHierarchyItem>>(
-                          done, [&result](std::vector<clang::clangd::TypeHierarchyItem>& subtypes) {
-                            append_range(result, std::move(subtypes));
-                          }));
-    done.wait();
-  }
+  return join(find_subtypes_per_item(items));
+}
 
-  return result;
+[[nodiscard]] auto Extractor::find_subtypes_per_item(std::vector<clang::clangd::TypeHierarchyItem> const& items)
+    -> std::vector<std::vector<clang::clangd::TypeHierarchyItem>> {
+  return send_all_and_wait<std::vector<clang::clangd::TypeHierarchyItem>>(
+      items,
+      [this](clang::clangd::TypeHierarchyItem const& item,
+             clang::clangd::Callback<std::vector<clang::clangd::TypeHierarchyItem>> callback) {
+        std::scoped_lock const lock{*mutex_};
+        server_->subTypes(item, std::move(callback));
+      });
 }
 
 [[nodiscard]] auto read_file(clang::clangd::PathRef file) -> std::string {
@@ -270,14 +540,37 @@ void Extractor::update_file(clang::clangd::PathRef file, llvm::StringRef content
   return std::move(oss).str();
 }
 
-[[nodiscard]] auto load_index(clang::clangd::PathRef index_file) -> std::unique_ptr<clang::clangd::SymbolIndex> {
+[[nodiscard]] auto make_base_map(clang::clangd::RelationSlab const& relations) -> Base_map {
+  Base_map result;
+  for (auto const& relation : relations) {
+    if (relation.Predicate == clang::clangd::RelationKind::BaseOf) {
+      result[relation.Object].push_back(relation.Subject);
+    }
+  }
+  return result;
+}
+
+[[nodiscard]] auto load_index(clang::clangd::PathRef index_file) -> Static_index {
   clang::clangd::log("Indexing using the index at {0}.", index_file.str());
 
   auto symbol_index{std::make_unique<clang::clangd::SwapIndex>(std::make_unique<clang::clangd::MemIndex>())};
-  if (auto index{clang::clangd::loadIndex(index_file, clang::clangd::SymbolOrigin::Static, /*UseDex=*/true)}) {
-    symbol_index->reset(std::move(index));
+  Base_map bases;
+  // Read as `clangd::loadIndex` does, except that the relations are also kept the other way round
+  auto buffer{llvm::MemoryBuffer::getFile(index_file, /*IsText=*/false, /*RequiresNullTerminator=*/false)};
+  if (!buffer) {
+    clang::clangd::elog("Can't open {0}: {1}", index_file, buffer.getError().message());
+  } else if (auto index{clang::clangd::readIndexFile((*buffer)->getBuffer(), clang::clangd::SymbolOrigin::Static)};
+             !index) {
+    clang::clangd::elog("Bad index file {0}: {1}", index_file, llvm::toString(index.takeError()));
+  } else {
+    clang::clangd::SymbolSlab symbols{index->Symbols ? std::move(*index->Symbols) : clang::clangd::SymbolSlab{}};
+    clang::clangd::RefSlab refs{index->Refs ? std::move(*index->Refs) : clang::clangd::RefSlab{}};
+    clang::clangd::RelationSlab relations{index->Relations ? std::move(*index->Relations)
+                                                           : clang::clangd::RelationSlab{}};
+    bases = make_base_map(relations);
+    symbol_index->reset(clang::clangd::dex::Dex::build(std::move(symbols), std::move(refs), std::move(relations)));
   }
-  return symbol_index;
+  return Static_index{.symbol_index{std::move(symbol_index)}, .bases{std::move(bases)}};
 }
 
 [[nodiscard]] auto make_extractor(clang::clangd::PathRef index_file,
@@ -301,6 +594,7 @@ void Extractor::update_file(clang::clangd::PathRef file, llvm::StringRef content
     return initer;
   })};
 
-  return Extractor{std::move(cdb), std::move(tfs), std::move(options), load_index(index_file)};
+  auto [symbol_index, bases]{load_index(index_file)};
+  return Extractor{std::move(cdb), std::move(tfs), std::move(options), std::move(symbol_index), std::move(bases)};
 }
 }  // namespace cppcia
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "cppcia/index_diff.hpp"
+
+#include "cppcia/extractor.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <clangd/index/Ref.h>
+#include <clangd/index/Serialization.h>
+#include <clangd/index/Symbol.h>
+#include <clangd/index/SymbolID.h>
+#include <clangd/index/SymbolLocation.h>
+#include <clangd/index/SymbolOrigin.h>
+#include <clangd/support/Path.h>
+#include <fmt/core.h>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+
+namespace cppcia {
+namespace {
+  // Positions shift whenever lines are added above, so only the file and the extent of a location are compared
+  [[nodiscard]] auto same_extent(clang::clangd::SymbolLocation const& lhs,
+                                 clang::clangd::SymbolLocation const& rhs) -> bool {
+    auto const extent{[](clang::clangd::SymbolLocation const& location) {
+      return std::pair{location.End.line() - location.Start.line(), location.End.column() - location.Start.column()};
+    }};
+    return llvm::StringRef{lhs.FileURI} == llvm::StringRef{rhs.FileURI} && extent(lhs) == extent(rhs);
+  }
+
+  [[nodiscard]] auto same_declaration(clang::clangd::Symbol const& lhs, clang::clangd::Symbol const& rhs) -> bool {
+    return lhs.SymInfo.Kind == rhs.SymInfo.Kind && lhs.Signature == rhs.Signature && lhs.ReturnType == rhs.ReturnType
+        && lhs.Type == rhs.Type && lhs.TemplateSpecializationArgs == rhs.TemplateSpecializationArgs
+        && same_extent(lhs.Definition, rhs.Definition)
+        && same_extent(lhs.CanonicalDeclaration, rhs.CanonicalDeclaration);
+  }
+}  // namespace
+
+auto load_slabs(clang::clangd::PathRef index_file) -> Index_slabs {
+  auto index{clang::clangd::readIndexFile(read_file(index_file), clang::clangd::SymbolOrigin::Static)};
+  if (!index) {
+    throw std::runtime_error{
+        fmt::format("Failed to read the index {}: {}", index_file.str(), llvm::toString(index.takeError()))};
+  }
+  return Index_slabs{.symbols{index->Symbols ? std::move(*index->Symbols) : clang::clangd::SymbolSlab{}},
+                     .refs{index->Refs ? std::move(*index->Refs) : clang::clangd::RefSlab{}}};
+}
+
+auto load_symbols(clang::clangd::PathRef index_file) -> clang::clangd::SymbolSlab {
+  return std::move(load_slabs(index_file).symbols);
+}
+
+auto diff_symbols(clang::clangd::SymbolSlab const& old_symbols, clang::clangd::SymbolSlab const& new_symbols)
+    -> std::vector<Changed_symbol> {
+  std::vector<Changed_symbol> result;
+  auto old_iter{old_symbols.begin()};
+  auto new_iter{new_symbols.begin()};
+  while (old_iter != old_symbols.end() || new_iter != new_symbols.end()) {
+    if (new_iter == new_symbols.end() || (old_iter != old_symbols.end() && old_iter->ID < new_iter->ID)) {
+      result.push_back(Changed_symbol{.change{Symbol_change::removed}, .symbol{&*old_iter}});
+      ++old_iter;
+    } else if (old_iter == old_symbols.end() || new_iter->ID < old_iter->ID) {
+      result.push_back(Changed_symbol{.change{Symbol_change::added}, .symbol{&*new_iter}});
+      ++new_iter;
+    } else {
+      if (!same_declaration(*old_iter, *new_iter)) {
+        result.push_back(Changed_symbol{.change{Symbol_change::changed}, .symbol{&*new_iter}});
+      }
+      ++old_iter;
+      ++new_iter;
+    }
+  }
+  return result;
+}
+
+auto find_referrers_of_removed(std::vector<Changed_symbol> const& changes,
+                               clang::clangd::RefSlab const& old_refs,
+                               clang::clangd::SymbolSlab const& new_symbols) -> std::vector<Changed_symbol> {
+  llvm::DenseSet<clang::clangd::SymbolID> removed;
+  llvm::DenseSet<clang::clangd::SymbolID> seen;
+  for (auto const& changed : changes) {
+    if (changed.change == Symbol_change::removed) {
+      removed.insert(changed.symbol->ID);
+    } else {
+      seen.insert(changed.symbol->ID);
+    }
+  }
+
+  std::vector<Changed_symbol> result;
+  for (auto const& [id, refs] : old_refs) {
+    if (!removed.contains(id)) {
+      continue;
+    }
+    for (auto const& ref : refs) {
+      if (ref.Container.isNull() || !seen.insert(ref.Container).second) {
+        continue;
+      }
+      if (auto const referrer{new_symbols.find(ref.Container)}; referrer != new_symbols.end()) {
+        result.push_back(Changed_symbol{.change{Symbol_change::changed}, .symbol{&*referrer}});
+      }
+    }
+  }
+  std::sort(result.begin(), result.end(), [](Changed_symbol const& lhs, Changed_symbol const& rhs) {
+    return lhs.symbol->ID < rhs.symbol->ID;
+  });
+  return result;
+}
+}  // namespace cppcia
\ No newline at end of file
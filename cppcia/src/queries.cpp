@@ -0,0 +1,465 @@
+#include "cppcia/queries.hpp"
+
+#include "cppcia/diff.hpp"
+#include "cppcia/extractor.hpp"
+#include "cppcia/index_diff.hpp"
+#include "cppcia/reference.hpp"
+#include "cppcia/referencer.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <clangd/Protocol.h>
+#include <clangd/index/Symbol.h>
+#include <ctre.hpp>
+#include <fmt/core.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+#include <nlohmann/json.hpp>
+#include <range/v3/all.hpp>
+
+namespace cppcia {
+namespace {
+  [[nodiscard]] auto trimmed(llvm::StringRef string) -> std::string {
+    return string.trim().str();
+  }
+
+  [[nodiscard]] auto strings_param(nlohmann::json const& params, char const* key) -> std::vector<std::string> {
+    if (!params.contains(key)) {
+      return {};
+    }
+    try {
+      return params.at(key).get<std::vector<std::string>>();
+    } catch (nlohmann::json::exception const&) {
+      throw std::invalid_argument{fmt::format("\"{}\" must be an array of strings", key)};
+    }
+  }
+
+  void reference_call(Referencer& referencer,  // NOLINT(*recursion*)
+                      Walk_budget& budget,
+                      Reference const& reference,
+                      Reference_graph_builder& result) {
+    switch (reference.kind) {
+      using enum SymbolKind;
+      case Constructor:
+      case Function:
+      case Interface:
+      case Method:
+      case Operator:
+        referencer.find_caller_hierarchies(reference, result, Edge_type::dashed, /*reverse_edge=*/true, &budget);
+        return;
+
+      case Array:
+      case Boolean:
+      case Class:
+      case Constant:
+      case Enum:
+      case EnumMember:
+      case Event:
+      case Field:
+      case File:
+      case Key:
+      case Module:
+      case Namespace:
+      case Null:
+      case Number:
+      case Object:
+      case Package:
+      case Property:
+      case String:
+      case Struct:
+      case TypeParameter:
+      case Variable:
+        return;
+    }
+  }
+
+  void reference_supertype(Referencer& referencer,  // NOLINT(*recursion*)
+                           Walk_budget& budget,
+                           Reference const& reference,
+                           Reference_graph_builder& result) {
+    switch (reference.kind) {
+      using enum SymbolKind;
+      case Class:
+      case Enum:
+      case Struct:
+        referencer.find_supertype_hierarchies(reference, result, Edge_type::dashed, /*reverse_edge=*/true, &budget);
+        return;
+
+      case Array:
+      case Boolean:
+      case Constant:
+      case Constructor:
+      case EnumMember:
+      case Event:
+      case Field:
+      case File:
+      case Function:
+      case Interface:
+      case Key:
+      case Method:
+      case Module:
+      case Namespace:
+      case Null:
+      case Number:
+      case Object:
+      case Operator:
+      case Package:
+      case Property:
+      case String:
+      case TypeParameter:
+      case Variable:
+        return;
+    }
+  }
+
+  void reference_subtype(Referencer& referencer,  // NOLINT(*recursion*)
+                         Walk_budget& budget,
+                         Reference const& reference,
+                         Reference_graph_builder& result) {
+    switch (reference.kind) {
+      using enum SymbolKind;
+      case Class:
+      case Enum:
+      case Struct:
+        referencer.find_subtype_hierarchies(reference, result, Edge_type::dashed, /*reverse_edge=*/false, &budget);
+        return;
+
+      case Array:
+      case Boolean:
+      case Constant:
+      case Constructor:
+      case EnumMember:
+      case Event:
+      case Field:
+      case File:
+      case Function:
+      case Interface:
+      case Key:
+      case Method:
+      case Module:
+      case Namespace:
+      case Null:
+      case Number:
+      case Object:
+      case Operator:
+      case Package:
+      case Property:
+      case String:
+      case TypeParameter:
+      case Variable:
+        return;
+    }
+  }
+
+  // The walks go first, so that a sink-backed `result` receives their vertices with the truncation they end with
+  // rather than the untruncated copies in the reference and container trees
+  void reference_on_option(Referencer& referencer,
+                           Impact_options const& options,
+                           Walk_budget& budget,
+                           Reference const& reference,
+                           Reference_graph_builder& result) {
+    auto references{referencer.find_references(reference)};
+    if (options.follow_contain_by) {
+      auto path{referencer.find_container_path(reference)};
+      if (options.follow_call || options.follow_subtype || options.follow_supertype) {
+        visit(path, [&](Reference const& node) {
+          if (options.follow_call) {
+            reference_call(referencer, budget, node, result);
+          }
+          if (options.follow_supertype) {
+            reference_supertype(referencer, budget, node, result);
+          }
+          if (options.follow_subtype) {
+            reference_subtype(referencer, budget, node, result);
+          }
+        });
+      }
+      result.merge(to_graph(path, Edge_type::dashed, true));
+    }
+    result.merge(to_graph(references, Edge_type::solid, /*reverse_edge=*/false));
+  }
+
+  void impact_file(Referencer& referencer,
+                   Impact_options const& options,
+                   Walk_budget& budget,
+                   llvm::StringRef file,
+                   Reference_graph_builder& result) {
+    auto outline{referencer.query_file(file)};
+    for (auto const& node : outline.nodes().subspan(1)) {
+      reference_on_option(referencer, options, budget, node.reference, result);
+    }
+    result.merge(to_graph(outline, Edge_type::solid, /*reverse_edge=*/false));
+  }
+
+  // All positions are in `file`, so that it's opened once and their hovers are sent together
+  void impact_locations(Referencer& referencer,
+                        Impact_options const& options,
+                        Walk_budget& budget,
+                        std::string const& file,
+                        std::vector<clang::clangd::Position> const& positions,
+                        Reference_graph_builder& result) {
+    std::vector<File_position> file_positions;
+    file_positions.reserve(positions.size());
+    for (auto const& pos : positions) {
+      file_positions.emplace_back(file, pos);
+    }
+
+    auto const querieds{referencer.query_locations(file_positions)};
+    for (std::size_t i{0}; i < querieds.size(); ++i) {
+      if (!querieds[i]) {
+        throw std::invalid_argument{
+            fmt::format("No symbol found in {}:{}:{}", file, positions[i].line, positions[i].character)};
+      }
+    }
+    for (auto const& queried : querieds) {
+      reference_on_option(referencer, options, budget, *queried, result);
+    }
+  }
+
+  // The innermost symbols whose ranges share a line with `changed_lines`, which come from `merged`, so that a change
+  // in a function body seeds the function rather than also its class and namespace. Symbols are taken from the
+  // outline, so that the file is queried once however many lines changed.
+  void impact_changed_lines(Referencer& referencer,
+                            Impact_options const& options,
+                            Walk_budget& budget,
+                            std::string const& file,
+                            std::vector<Line_range> const& changed_lines,
+                            Reference_graph_builder& result) {
+    auto const outline{referencer.query_file(file)};
+    auto const changed{[&changed_lines](Reference_tree::Node const& node) {
+      auto const& range{node.reference.full_range.value_or(node.reference.name_range)};
+      return intersects(changed_lines, range.start.line, range.end.line);
+    }};
+    for (auto const& node : outline.nodes().subspan(1)) {
+      if (changed(node) && ranges::none_of(outline.children(node), changed)) {
+        reference_on_option(referencer, options, budget, node.reference, result);
+      }
+    }
+  }
+
+  // Removed symbols are only known by the old index, so they are added as they were instead of being followed. Their
+  // referrers come as changed symbols of their own.
+  void impact_symbol(Referencer& referencer,
+                     Impact_options const& options,
+                     Walk_budget& budget,
+                     Changed_symbol const& changed,
+                     Reference_graph_builder& result) {
+    auto const reference{referencer.query_symbol(*changed.symbol)};
+    if (!reference) {
+      return;
+    }
+    if (changed.change == Symbol_change::removed) {
+      result.add_vertex(*reference);
+      return;
+    }
+    reference_on_option(referencer, options, budget, *reference, result);
+  }
+
+  void impact_name(Referencer& referencer,
+                   Impact_options const& options,
+                   Walk_budget& budget,
+                   llvm::StringRef name,
+                   bool fuzzy,
+                   Reference_graph_builder& result) {
+    auto querieds{referencer.query_name(name, fuzzy)};
+    for (auto& queried : querieds) {
+      reference_on_option(referencer, options, budget, queried, result);
+    }
+  }
+}  // namespace
+
+auto existing_absolute(std::filesystem::path const& path) -> std::string {
+  if (!std::filesystem::exists(path)) {
+    throw std::invalid_argument{fmt::format("Path {} doesn't exist!", path.string())};
+  }
+  return std::filesystem::absolute(path).string();
+}
+auto existing_absolute(std::string const& path) -> std::string {
+  return existing_absolute(std::filesystem::path{path});
+}
+
+auto canonical_file(std::string const& file) -> std::string {
+  return std::filesystem::path{existing_absolute(file)}.lexically_normal().string();
+}
+
+auto parse_location(llvm::StringRef location) -> std::pair<std::string, clang::clangd::Position> {
+  using namespace ctre::literals;  // NOLINT(*using-namespace*)
+  auto [whole, file, line, character]{R"ctre((.*?):(.*?):(.*?))ctre"_ctre.match(location)};
+  if (!whole) {
+    throw std::invalid_argument{fmt::format("{} is not a valid location!", location.data())};
+  }
+  return {file.to_string(), clang::clangd::Position{line.to_number(), character.to_number()}};
+}
+
+auto sorted_unique(std::vector<std::string> strings) -> std::vector<std::string> {
+  for (auto& string : strings) {
+    string = trimmed(string);
+  }
+  ranges::sort(strings);
+  strings.erase(std::unique(strings.begin(), strings.end()), strings.end());
+  return strings;
+}
+
+void append(Queries& self, Queries other) {
+  auto const append_moved{[](std::vector<std::string>& lhs, std::vector<std::string>& rhs) {
+    lhs.insert(lhs.end(), std::make_move_iterator(rhs.begin()), std::make_move_iterator(rhs.end()));
+  }};
+  append_moved(self.files, other.files);
+  append_moved(self.locations, other.locations);
+  append_moved(self.names, other.names);
+  append_moved(self.names_fuzzy, other.names_fuzzy);
+  append_moved(self.diffs, other.diffs);
+  append_moved(self.old_indexes, other.old_indexes);
+}
+
+auto json_queries(nlohmann::json const& json) -> Queries {
+  if (!json.is_object()) {
+    throw std::invalid_argument{"Queries must be a JSON object"};
+  }
+  return Queries{.files{strings_param(json, "files")},
+                 .locations{strings_param(json, "locations")},
+                 .names{strings_param(json, "names")},
+                 .names_fuzzy{strings_param(json, "names_fuzzy")},
+                 .diffs{strings_param(json, "diffs")},
+                 .old_indexes{strings_param(json, "old_indexes")}};
+}
+
+auto read_queries(std::string const& file) -> Queries {
+  auto const content{read_file(existing_absolute(file))};
+  if (llvm::StringRef{content}.ltrim().starts_with("{")) {
+    try {
+      return json_queries(nlohmann::json::parse(content));
+    } catch (nlohmann::json::parse_error const& error) {
+      throw std::invalid_argument{fmt::format("{} is not valid JSON: {}", file, error.what())};
+    }
+  }
+
+  Queries result;
+  llvm::SmallVector<llvm::StringRef> lines;
+  llvm::StringRef{content}.split(lines, '\n');
+  for (std::size_t i{0}; i < lines.size(); ++i) {
+    auto const line{lines[i].trim()};
+    if (line.empty() || line.starts_with("#")) {
+      continue;
+    }
+
+    auto const [kind, value]{line.split(' ')};
+    if (kind == "file") {
+      result.files.push_back(trimmed(value));
+    } else if (kind == "location") {
+      result.locations.push_back(trimmed(value));
+    } else if (kind == "name") {
+      result.names.push_back(trimmed(value));
+    } else if (kind == "name-fuzzy") {
+      result.names_fuzzy.push_back(trimmed(value));
+    } else if (kind == "diff") {
+      result.diffs.push_back(trimmed(value));
+    } else if (kind == "old-index") {
+      result.old_indexes.push_back(trimmed(value));
+    } else {
+      throw std::invalid_argument{fmt::format("{}:{}: unknown query kind {}", file, i + 1, kind.str())};
+    }
+  }
+  return result;
+}
+
+auto collect_seeds(Queries const& queries, Impact_options const& options) -> std::vector<Seed> {
+  struct File_queries {
+   public:
+    // NOLINTBEGIN(*non-private-member*)
+    bool whole{false};
+    std::vector<clang::clangd::Position> positions;
+    std::vector<Line_range> changed_lines;
+    // NOLINTEND(*non-private-member*)
+  };
+  std::map<std::string, File_queries> files;
+  for (auto const& file : queries.files) {
+    files[canonical_file(file)].whole = true;
+  }
+  for (auto const& location : queries.locations) {
+    auto [file, pos]{parse_location(location)};
+    files[canonical_file(file)].positions.push_back(pos);
+  }
+  for (auto const& diff : queries.diffs) {
+    for (auto& file_diff : parse_unified_diff(read_file(existing_absolute(diff)))) {
+      auto& changed_lines{files[canonical_file(file_diff.file)].changed_lines};
+      changed_lines.insert(changed_lines.end(), file_diff.changed_lines.begin(), file_diff.changed_lines.end());
+    }
+  }
+
+  std::vector<Seed> result;
+  for (auto& [path, file_queries] : files) {
+    std::sort(file_queries.positions.begin(), file_queries.positions.end());
+    file_queries.positions.erase(std::unique(file_queries.positions.begin(), file_queries.positions.end()),
+                                 file_queries.positions.end());
+    file_queries.changed_lines = merged(std::move(file_queries.changed_lines));
+    result.emplace_back([path{path}, file_queries{std::move(file_queries)}, options](Referencer& referencer,
+                                                                                   Reference_graph_builder& graph) {
+      Walk_budget budget{referencer.options()};
+      if (file_queries.whole) {
+        impact_file(referencer, options, budget, path, graph);
+      }
+      if (!file_queries.positions.empty()) {
+        impact_locations(referencer, options, budget, path, file_queries.positions, graph);
+      }
+      if (!file_queries.whole && !file_queries.changed_lines.empty()) {
+        impact_changed_lines(referencer, options, budget, path, file_queries.changed_lines, graph);
+      }
+    });
+  }
+
+  for (auto const& name : sorted_unique(queries.names)) {
+    result.emplace_back([name, options](Referencer& referencer, Reference_graph_builder& graph) {
+      Walk_budget budget{referencer.options()};
+      impact_name(referencer, options, budget, name, false, graph);
+    });
+  }
+
+  for (auto const& name : sorted_unique(queries.names_fuzzy)) {
+    result.emplace_back([name, options](Referencer& referencer, Reference_graph_builder& graph) {
+      Walk_budget budget{referencer.options()};
+      impact_name(referencer, options, budget, name, true, graph);
+    });
+  }
+
+  if (!queries.old_indexes.empty()) {
+    // Seeds point into the slabs, which are kept alive by the seeds themselves
+    auto const new_symbols{
+        std::make_shared<clang::clangd::SymbolSlab const>(load_symbols(existing_absolute(options.index_file)))};
+    auto old_indexes{queries.old_indexes
+                     | ranges::views::transform([](std::string const& old_index) {
+                         return canonical_file(trimmed(old_index));
+                       })
+                     | ranges::to<std::vector>()};
+    // The changes found against one old index are one seed, so that they draw from one budget
+    for (auto const& old_index : sorted_unique(std::move(old_indexes))) {
+      auto old_slabs{load_slabs(old_index)};
+      auto const old_symbols{std::make_shared<clang::clangd::SymbolSlab const>(std::move(old_slabs.symbols))};
+      auto changes{diff_symbols(*old_symbols, *new_symbols)};
+      auto referrers{find_referrers_of_removed(changes, old_slabs.refs, *new_symbols)};
+      changes.insert(changes.end(), referrers.begin(), referrers.end());
+      if (changes.empty()) {
+        continue;
+      }
+      result.emplace_back([old_symbols, new_symbols, changes{std::move(changes)}, options](
+                              Referencer& referencer, Reference_graph_builder& graph) {
+        Walk_budget budget{referencer.options()};
+        for (auto const& changed : changes) {
+          impact_symbol(referencer, options, budget, changed, graph);
+        }
+      });
+    }
+  }
+
+  return result;
+}
+}  // namespace cppcia
\ No newline at end of file
@@ -1,8 +1,10 @@
 #include "cppcia/reference.hpp"
 
-#include <queue>
+#include "cppcia/string_pool.hpp"
+
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <Protocol.h>
 #include <fmt/core.h>
@@ -18,17 +20,24 @@ namespace cppcia {
 }
 
 [[nodiscard]] auto make_file_reference(llvm::StringRef file) -> Reference {
+  return make_file_reference(Interned_uri{clang::clangd::URIForFile::canonicalize(file, file)});
+}
+
+[[nodiscard]] auto make_file_reference(URIForFile const& uri) -> Reference {
+  return make_file_reference(uri.file());
+}
+
+[[nodiscard]] auto make_file_reference(Interned_uri uri) -> Reference {
   return Reference{.kind{SymbolKind::File},
-                   .uri{clang::clangd::URIForFile::canonicalize(file, file)},
+                   .uri{uri},
                    .name_range{},
                    .full_range{},
                    .namespace_scopes{},
                    .local_scopes{},
-                   .name{}};
-}
-
-[[nodiscard]] auto make_file_reference(URIForFile const& uri) -> Reference {
-  return make_file_reference(uri.file());
+                   .name{},
+                   .symbol_id{},
+                   .truncated{false},
+                   .expanded{false}};
 }
 
 [[nodiscard]] auto to_file_pos(URIForFile const& uri,
@@ -41,34 +50,25 @@ namespace cppcia {
 }
 
 [[nodiscard]] auto to_file_pos(Reference const& reference) -> std::pair<std::string, clang::clangd::Position> {
-  return to_file_pos(reference.uri, reference.name_range);
+  return std::pair<std::string, clang::clangd::Position>{reference.uri.file(), reference.name_range.start};
 }
 
 [[nodiscard]] auto to_graph(Reference_tree const& tree, Edge_type edge_type, bool reverse_edge) -> Reference_graph {
   Reference_graph result;
 
-  struct Value_type {
-    Reference_tree const* reference_tree;
-    graaf::vertex_id_t id;
-  };
-
-  std::queue<Value_type> queue;
-  {
-    auto id{result.add_vertex(tree.reference)};
-    queue.emplace(&tree, id);
-  }
-  while (!queue.empty()) {
-    Value_type current{queue.front()};
-    queue.pop();
+  // Parents precede their children in the node array, so their vertices always exist when the edge is added
+  std::vector<graaf::vertex_id_t> ids;
+  ids.reserve(tree.size());
+  for (auto const& node : tree.nodes()) {
+    ids.push_back(result.add_vertex(node.reference));
+    if (tree.id_of(node) == Reference_tree::root_id) {
+      continue;
+    }
 
-    for (auto const& child : current.reference_tree->children) {
-      auto child_id{result.add_vertex(child.reference)};
-      if (reverse_edge) {
-        result.add_edge(child_id, current.id, edge_type);
-      } else {
-        result.add_edge(current.id, child_id, edge_type);
-      }
-      queue.emplace(&child, child_id);
+    if (reverse_edge) {
+      result.add_edge(ids.back(), ids[node.parent], edge_type);
+    } else {
+      result.add_edge(ids[node.parent], ids.back(), edge_type);
     }
   }
 
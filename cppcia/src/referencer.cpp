@@ -1,108 +1,293 @@
 #include "cppcia/referencer.hpp"
 
+#include "cppcia/detail/hierarchy.hpp"
 #include "cppcia/extractor.hpp"
 #include "cppcia/reference.hpp"
+#include "cppcia/string_pool.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <numeric>
 #include <optional>
+#include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include <clang/Index/IndexSymbol.h>
+#include <clangd/FindSymbols.h>
 #include <clangd/Hover.h>
 #include <clangd/Protocol.h>
+#include <clangd/SourceCode.h>
 #include <clangd/XRefs.h>
+#include <clangd/index/Symbol.h>
+#include <clangd/index/SymbolID.h>
+#include <clangd/support/Logger.h>
 #include <clangd/support/Path.h>
 #include <fmt/core.h>
 #include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
 #include <range/v3/all.hpp>
 
 namespace cppcia {
 void Referencer::update_file(clang::clangd::PathRef file, llvm::StringRef content) {
-  extractor_.update_file(file, content);
+  if (extractor_.update_file(file, content)) {
+    std::scoped_lock const lock{*mutex_};
+    documents_.erase(file);
+  }
 }
 
 namespace {
-  void query_file_impl(Referencer& referencer,  // NOLINT(*recursion*)
-                       Reference_tree& result,
-                       clang::clangd::PathRef file,
-                       clang::clangd::DocumentSymbol const& symbol) {
-    result.reference = to_reference(referencer, file, symbol);
-    for (auto const& symbol_child : symbol.children) {
-      Reference_tree result_child;
-      query_file_impl(referencer, result_child, file, symbol_child);
-      result.children.emplace_back(std::move(result_child));
+  [[nodiscard]] auto make_reference(clang::clangd::PathRef file, std::optional<clang::clangd::HoverInfo> info)
+      -> std::optional<Reference> {
+    if (!info) {
+      return std::nullopt;
+    }
+    return Reference{.kind{clang::clangd::indexSymbolKindToSymbolKind(info->Kind)},
+                     .uri{Interned_uri{clang::clangd::URIForFile::canonicalize(file, file)}},
+                     .name_range{*info->SymRange},
+                     .full_range{},
+                     .namespace_scopes{Interned_string{*info->NamespaceScope}},
+                     .local_scopes{Interned_string{info->LocalScope}},
+                     .name{Interned_string{info->Name}},
+                     .symbol_id{},
+                     .truncated{false},
+                     .expanded{false}};
+  }
+
+  // A document symbol in breadth-first order, where the children of each symbol are stored next to each other
+  struct Flat_symbol {
+   public:
+    // NOLINTBEGIN(*non-private-member*)
+    clang::clangd::DocumentSymbol const* symbol;
+    std::size_t first_child;
+    // NOLINTEND(*non-private-member*)
+  };
+
+  [[nodiscard]] auto flatten(std::vector<clang::clangd::DocumentSymbol> const& symbols) -> std::vector<Flat_symbol> {
+    std::vector<Flat_symbol> result;
+    for (auto const& symbol : symbols) {
+      result.push_back(Flat_symbol{.symbol{&symbol}, .first_child{0}});
+    }
+    for (std::size_t i{0}; i < result.size(); ++i) {
+      result[i].first_child = result.size();
+      for (auto const& child : result[i].symbol->children) {
+        result.push_back(Flat_symbol{.symbol{&child}, .first_child{0}});
+      }
     }
+    return result;
+  }
+
+  [[nodiscard]] auto outline_start(Reference_tree::Node const& node) -> clang::clangd::Position {
+    return node.reference.full_range.value_or(node.reference.name_range).start;
+  }
+
+  // Siblings in an outline don't overlap unless they're declared together like `int a, b;`, in which case they start
+  // at the same position. So only the siblings sharing the last start before the reference can contain it.
+  [[nodiscard]] auto find_containing_child(Reference_tree const& tree,
+                                           Reference_tree::Node const& node,
+                                           Reference const& reference) -> Reference_tree::Node const* {
+    auto children{tree.children(node)};
+    auto last{ranges::upper_bound(children, reference.name_range.start, std::less{}, outline_start)};
+    if (last == children.begin()) {
+      return nullptr;
+    }
+    auto first{ranges::lower_bound(children, outline_start(*std::prev(last)), std::less{}, outline_start)};
+
+    auto iter{std::find_if(first, last, [&reference](Reference_tree::Node const& child) {
+      return child.reference.contains(reference);
+    })};
+    return iter == last ? nullptr : &*iter;
+  }
+
+  template <typename Item>
+  [[nodiscard]] auto query_items(Referencer& referencer,
+                                 std::vector<Item> const& items) -> std::vector<std::optional<Reference>> {
+    std::vector<std::optional<Reference>> result{referencer.query_locations(
+        items | ranges::views::transform([](Item const& item) { return to_file_pos(item.uri, item.selectionRange); })
+        | ranges::to<std::vector>())};
+
+    for (std::size_t i{0}; i < items.size(); ++i) {
+      if (result[i]) {
+        result[i]->full_range = items[i].range;
+      }
+    }
+    return result;
+  }
+
+  template <typename Item>
+  [[nodiscard]] auto to_references(Referencer& referencer, std::vector<Item> const& items) -> std::vector<Reference> {
+    std::vector<Reference> result;
+    result.reserve(items.size());
+    for (auto& reference : query_items(referencer, items)) {
+      if (reference) {
+        result.emplace_back(*std::move(reference));
+      }
+    }
+    return result;
   }
 }  // namespace
 
 [[nodiscard]] auto Referencer::query_file(clang::clangd::PathRef file) -> Reference_tree {
+  return *outline(file);
+}
+
+[[nodiscard]] auto Referencer::outline(clang::clangd::PathRef file) -> std::shared_ptr<Reference_tree const> {
   update_real_file_or_test(file);
+  {
+    std::scoped_lock const lock{*mutex_};
+    if (auto iter{documents_.find(file)}; iter != documents_.end() && iter->second.outline) {
+      return iter->second.outline;
+    }
+  }
+
   std::vector<clang::clangd::DocumentSymbol> symbols{extractor_.query_file(file)};
-  return {make_file_reference(file),
-          symbols | ranges::views::transform([&](clang::clangd::DocumentSymbol const& symbol) {
-            Reference_tree result;
-            query_file_impl(*this, result, file, symbol);
-            return result;
-          }) | ranges::to<std::vector>()};
+  std::vector<Flat_symbol> flat_symbols{flatten(symbols)};
+
+  std::vector<std::optional<Reference>> references{query_locations(
+      flat_symbols | ranges::views::transform([file](Flat_symbol const& flat_symbol) {
+        return File_position{file.str(), flat_symbol.symbol->selectionRange.start};
+      })
+      | ranges::to<std::vector>())};
+
+  // Each pending entry is a node whose children are the flat symbols [first, first + count)
+  struct Pending {
+   public:
+    // NOLINTBEGIN(*non-private-member*)
+    Reference_tree::Node_id node;
+    std::size_t first;
+    std::size_t count;
+    // NOLINTEND(*non-private-member*)
+  };
+
+  Reference_tree result{make_file_reference(file)};
+  std::vector<Pending> pendings{Pending{.node{Reference_tree::root_id}, .first{0}, .count{symbols.size()}}};
+  for (std::size_t next{0}; next < pendings.size(); ++next) {
+    Pending const pending{pendings[next]};
+
+    std::vector<std::size_t> order(pending.count);
+    std::iota(order.begin(), order.end(), pending.first);
+    ranges::stable_sort(order, std::less{}, [&flat_symbols](std::size_t i) {
+      return flat_symbols[i].symbol->range.start;
+    });
+
+    std::vector<Reference> children;
+    children.reserve(order.size());
+    for (std::size_t i : order) {
+      Reference child{*std::move(references[i])};
+      child.full_range = flat_symbols[i].symbol->range;
+      children.push_back(std::move(child));
+    }
+
+    auto const first_child{result.add_children(pending.node, std::move(children))};
+    for (std::size_t j{0}; j < order.size(); ++j) {
+      pendings.push_back(Pending{.node{first_child + j},
+                                 .first{flat_symbols[order[j]].first_child},
+                                 .count{flat_symbols[order[j]].symbol->children.size()}});
+    }
+  }
+
+  // Another thread may have built the same outline meanwhile, keep the first one so that both see the same tree
+  std::scoped_lock const lock{*mutex_};
+  auto& outline{documents_[file].outline};
+  if (!outline) {
+    outline = std::make_shared<Reference_tree const>(std::move(result));
+  }
+  return outline;
 }
 
 [[nodiscard]] auto Referencer::query_location(clang::clangd::PathRef file,
                                               clang::clangd::Position pos) -> std::optional<Reference> {
-  update_real_file_or_test(file);
-  std::optional<clang::clangd::HoverInfo> info{extractor_.query_location_info(file, pos)};
-  if (!info) {
-    return std::nullopt;
+  return std::move(query_locations({File_position{file.str(), pos}}).front());
+}
+
+[[nodiscard]] auto Referencer::query_locations(std::vector<File_position> const& positions)
+    -> std::vector<std::optional<Reference>> {
+  std::unordered_set<std::string> updated_files;
+  for (auto const& [file, _] : positions) {
+    if (updated_files.insert(file).second) {
+      update_real_file_or_test(file);
+    }
   }
-  return Reference{.kind{clang::clangd::indexSymbolKindToSymbolKind(info->Kind)},
-                   .uri{clang::clangd::URIForFile::canonicalize(file, file)},
-                   .name_range{*info->SymRange},
-                   .full_range{},
-                   .namespace_scopes{std::move(*info->NamespaceScope)},
-                   .local_scopes{std::move(info->LocalScope)},
-                   .name{std::move(info->Name)}};
+
+  std::vector<std::optional<Reference>> result(positions.size());
+
+  std::vector<File_position> uncached_positions;
+  std::vector<std::size_t> uncached_indices;
+  {
+    std::scoped_lock const lock{*mutex_};
+    for (std::size_t i{0}; i < positions.size(); ++i) {
+      auto const& [file, pos]{positions[i]};
+      auto const& references{documents_[file].references};
+      if (auto iter{references.find(pos)}; iter != references.end()) {
+        result[i] = iter->second;
+      } else {
+        uncached_positions.push_back(positions[i]);
+        uncached_indices.push_back(i);
+      }
+    }
+  }
+
+  std::vector<std::optional<clang::clangd::HoverInfo>> infos{extractor_.query_location_infos(uncached_positions)};
+  for (std::size_t i{0}; i < infos.size(); ++i) {
+    auto const& [file, _]{uncached_positions[i]};
+    result[uncached_indices[i]] = make_reference(file, std::move(infos[i]));
+  }
+
+  std::scoped_lock const lock{*mutex_};
+  for (std::size_t i{0}; i < uncached_positions.size(); ++i) {
+    auto const& [file, pos]{uncached_positions[i]};
+    documents_[file].references.try_emplace(pos, result[uncached_indices[i]]);
+  }
+  return result;
 }
 
 [[nodiscard]] auto Referencer::query_name(llvm::StringRef name, bool fuzzy) -> std::vector<Reference> {
   std::vector<clang::clangd::SymbolInformation> symbols{extractor_.query_name(name, fuzzy)};
+  std::vector<std::optional<Reference>> references{
+      query_locations(symbols | ranges::views::transform([](clang::clangd::SymbolInformation const& symbol) {
+                        return to_file_pos(symbol.location);
+                      })
+                      | ranges::to<std::vector>())};
 
   std::vector<Reference> result{};
-  for (auto const& symbol : symbols) {
-    std::optional<Reference> reference{query_location(symbol.location.uri.file(), symbol.location.range.start)};
+  for (auto& reference : references) {
     if (reference) {
-      result.emplace_back(*reference);
+      result.emplace_back(*std::move(reference));
     }
   }
   return result;
 }
 
 [[nodiscard]] auto Referencer::find_container(Reference const& reference) -> Reference {
-  Reference_tree tree{query_file(reference.uri.file())};
-  while (true) {
-    auto iter{ranges::find_if(tree.children, [&reference](auto const& child) {
-      return child.reference.contains(reference) && child.reference != reference;
-    })};
-    if (iter == tree.children.end()) {
+  auto const tree{outline(reference.uri.file())};
+  Reference_tree::Node const* current{&tree->node(Reference_tree::root_id)};
+  while (Reference_tree::Node const* child{find_containing_child(*tree, *current, reference)}) {
+    if (child->reference == reference) {
       break;
     }
-    tree = std::move(*iter);
+    current = child;
   }
-  return tree.reference;
+  return current->reference;
 }
 
 [[nodiscard]] auto Referencer::find_container_path(Reference const& reference) -> Reference_tree {
-  Reference_tree tree{query_file(reference.uri.file())};
+  auto const tree{outline(reference.uri.file())};
+  Reference_tree::Node const* current{&tree->node(Reference_tree::root_id)};
 
-  for (Reference_tree* current{&tree}; true;) {
-    auto iter{ranges::find_if(current->children,
-                              [&reference](auto const& child) { return child.reference.contains(reference); })};
-    if (iter == current->children.end()) {
-      break;
-    }
-    current->children = std::vector{std::move(*iter)};
-    current           = &current->children.front();
+  Reference_tree result{current->reference};
+  for (Reference_tree::Node_id current_result{Reference_tree::root_id};
+       Reference_tree::Node const* child{find_containing_child(*tree, *current, reference)};
+       current = child) {
+    current_result = result.add_child(current_result, child->reference);
   }
-
-  return tree;
+  return result;
 }
 
 [[nodiscard]] auto Referencer::find_type(Reference const& reference) -> Reference {
@@ -118,28 +303,142 @@ namespace {
     return std::nullopt;
   }
   Location preferred_location{symbols.front().PreferredDeclaration};
-  return query_location(preferred_location);
+  std::optional<Reference> result{query_location(preferred_location)};
+  if (result) {
+    result->symbol_id = symbols.front().ID;
+  }
+  return result;
 }
 
 [[nodiscard]] auto Referencer::find_references(Reference const& reference) -> Reference_tree {
   Reference root{find_preferred_declaration(reference).value_or(reference)};
+  auto const is_not_root{[&root](Location const& location) {
+    return !(root.uri.file() == location.uri.file() && root.name_range == location.range);
+  }};
+
+  if (options_.index_only && root.symbol_id) {
+    // Every reference resolves to the root symbol, so its location is all we need from the index
+    std::vector<Location> locations{extractor_.find_index_references(root.symbol_id)};
+    Reference_tree result{root};
+    // clang-format off
+    result.add_children(
+        Reference_tree::root_id,
+        locations
+            | ranges::views::filter(is_not_root)
+            | ranges::views::transform([&root](Location const& location) {
+                Reference child{root};
+                child.uri        = Interned_uri{location.uri};
+                child.name_range = location.range;
+                child.full_range = std::nullopt;
+                return child;
+              })
+            | ranges::to<std::vector>());
+    // clang-format on
+    return result;
+  }
 
   auto [file, pos]{to_file_pos(reference)};
   clang::clangd::ReferencesResult references{extractor_.find_references(file, pos)};
 
-  return Reference_tree{
-      root,
-      // clang-format off
+  // clang-format off
+  std::vector<File_position> positions{
       references.References
-          | ranges::views::transform([](clang::clangd::ReferencesResult::Reference const& value) {
-              return static_cast<Location>(value.Loc);  // NOLINT(*slicing*)
-            })
-          | ranges::views::filter([&](Location const& location) {
-              return !(root.uri == location.uri && root.name_range == location.range);
-            })
-          | ranges::views::transform([this](Location const& location) { return Reference_tree{*query_location(location), {}}; })
-          | ranges::to<std::vector>()};
+      | ranges::views::transform([](clang::clangd::ReferencesResult::Reference const& value) {
+          return static_cast<Location>(value.Loc);  // NOLINT(*slicing*)
+        })
+      | ranges::views::filter(is_not_root)
+      | ranges::views::transform([](Location const& location) { return to_file_pos(location); })
+      | ranges::to<std::vector>()};
+
+  std::vector<std::optional<Reference>> children{query_locations(positions)};
+
+  Reference_tree result{std::move(root)};
+  result.add_children(
+      Reference_tree::root_id,
+      children
+          | ranges::views::transform([](std::optional<Reference>& child) { return *std::move(child); })
+          | ranges::to<std::vector>());
   // clang-format on
+  return result;
+}
+
+Walk_budget::Walk_budget(Referencer_options const& options)
+    : max_depth_{options.max_depth},
+      vertices_left_{options.max_vertices},
+      deadline_{options.timeout ? std::optional{std::chrono::steady_clock::now() + *options.timeout} : std::nullopt} {}
+
+[[nodiscard]] auto Walk_budget::out_of_depth(std::size_t depth) const -> bool {
+  return max_depth_ && depth >= *max_depth_;
+}
+
+[[nodiscard]] auto Walk_budget::out_of_vertices() const -> bool {
+  return vertices_left_ && *vertices_left_ == 0;
+}
+
+[[nodiscard]] auto Walk_budget::out_of_time() const -> bool {
+  return deadline_ && std::chrono::steady_clock::now() >= *deadline_;
+}
+
+void Walk_budget::take_vertex() {
+  if (vertices_left_ && *vertices_left_ > 0) {
+    --*vertices_left_;
+  }
+}
+
+namespace {
+  [[nodiscard]] auto to_ids(std::vector<clang::clangd::Symbol> const& symbols) -> std::vector<clang::clangd::SymbolID> {
+    return symbols | ranges::views::transform([](clang::clangd::Symbol const& symbol) { return symbol.ID; })
+           | ranges::to<std::vector>();
+  }
+}  // namespace
+
+[[nodiscard]] auto Referencer::split_scope(llvm::StringRef scope) -> std::pair<Interned_string, Interned_string> {
+  {
+    std::scoped_lock const lock{*mutex_};
+    if (auto iter{scope_splits_.find(scope)}; iter != scope_splits_.end()) {
+      return iter->second;
+    }
+  }
+
+  // The index only records the whole scope, so find where the namespaces end by looking up each scope component
+  std::size_t namespace_size{0};
+  for (llvm::StringRef rest{scope}; !rest.empty();) {
+    auto [component, remaining]{rest.split("::")};
+    auto symbols{extractor_.query_index_name(scope.take_front(namespace_size), component)};
+    if (ranges::any_of(symbols, [](clang::clangd::Symbol const& symbol) {
+          return symbol.SymInfo.Kind != clang::index::SymbolKind::Namespace;
+        })) {
+      break;
+    }
+    namespace_size = scope.size() - remaining.size();
+    rest           = remaining;
+  }
+
+  std::pair<Interned_string, Interned_string> result{Interned_string{scope.take_front(namespace_size)},
+                                                     Interned_string{scope.drop_front(namespace_size)}};
+  std::scoped_lock const lock{*mutex_};
+  scope_splits_.try_emplace(scope, result);
+  return result;
+}
+
+[[nodiscard]] auto Referencer::to_index_reference(clang::clangd::Symbol const& symbol) -> std::optional<Reference> {
+  auto location{clang::clangd::symbolToLocation(symbol, "")};
+  if (!location) {
+    clang::clangd::elog("{0}", llvm::toString(location.takeError()));
+    return std::nullopt;
+  }
+
+  auto [namespace_scopes, local_scopes]{split_scope(symbol.Scope)};
+  return Reference{.kind{clang::clangd::indexSymbolKindToSymbolKind(symbol.SymInfo.Kind)},
+                   .uri{Interned_uri{location->uri}},
+                   .name_range{location->range},
+                   .full_range{},
+                   .namespace_scopes{namespace_scopes},
+                   .local_scopes{local_scopes},
+                   .name{Interned_string{symbol.Name}},
+                   .symbol_id{symbol.ID},
+                   .truncated{false},
+                   .expanded{false}};
 }
 
 [[nodiscard]] auto Referencer::find_direct_callers(Reference const& reference) -> std::vector<Reference> {
@@ -147,106 +446,183 @@ namespace {
   std::vector<clang::clangd::CallHierarchyIncomingCall> callers{
       extractor_.find_callers(extractor_.prepare_call_hierarchy(file, pos))};
   // clang-format off
-  return callers
-         | ranges::views::transform([this](clang::clangd::CallHierarchyIncomingCall const& caller) {
-             return to_reference(*this, caller.from);
-           })
-         | ranges::to<std::vector>();
+  return to_references(*this,
+                       callers
+                       | ranges::views::transform([](clang::clangd::CallHierarchyIncomingCall const& caller) {
+                           return caller.from;
+                         })
+                       | ranges::to<std::vector>());
   // clang-format on
 }
 
-namespace {
-  void find_caller_hierarchies_impl(Referencer& referencer,  //  NOLINT(*recursion*)
-                                    Reference_tree& result,
-                                    clang::clangd::CallHierarchyItem item) {
-    result.reference = to_reference(referencer, item);
-    for (auto caller : referencer.extractor().find_callers(std::vector{std::move(item)})) {
-      Reference_tree child;
-      find_caller_hierarchies_impl(referencer, child, std::move(caller.from));
-      result.children.emplace_back(std::move(child));
+void Referencer::find_caller_hierarchies(Reference const& reference,
+                                         Reference_graph_builder& output,
+                                         Edge_type edge_type,
+                                         bool reverse_edge,
+                                         Walk_budget* budget) {
+  Walk_budget own_budget{options_};
+  Walk_budget& walk_budget{budget != nullptr ? *budget : own_budget};
+  Reference root{*find_preferred_declaration(reference)};
+
+  if (options_.index_only && root.symbol_id) {
+    std::vector<clang::clangd::Symbol> symbols{extractor_.lookup_index_symbols({root.symbol_id})};
+    if (!symbols.empty()) {
+      // The index records the container of each reference, so the whole caller graph is walked in memory
+      detail::find_hierarchies(
+          std::move(root),
+          std::move(symbols.front()),
+          [this](std::vector<clang::clangd::Symbol> const& frontier) {
+            return extractor_.find_index_callers_per_id(to_ids(frontier));
+          },
+          [this](std::vector<clang::clangd::Symbol> const& callers) {
+            return callers
+                   | ranges::views::transform(
+                       [this](clang::clangd::Symbol const& caller) { return to_index_reference(caller); })
+                   | ranges::to<std::vector>();
+          },
+          edge_type,
+          reverse_edge,
+          walk_budget,
+          output);
+      return;
     }
   }
-}  // namespace
 
-[[nodiscard]] auto Referencer::find_caller_hierarchies(Reference const& reference) -> Reference_tree {
-  auto [file, pos]{to_file_pos(*find_preferred_declaration(reference))};
+  auto [file, pos]{to_file_pos(root)};
   std::vector<clang::clangd::CallHierarchyItem> items{extractor_.prepare_call_hierarchy(file, pos)};
   assert(!items.empty());
 
-  Reference_tree result;
-  find_caller_hierarchies_impl(*this, result, items.front());
-  return result;
+  detail::find_hierarchies(
+      to_references(*this, std::vector{items.front()}).front(),
+      items.front(),
+      [this](std::vector<clang::clangd::CallHierarchyItem> const& frontier) {
+        std::vector<std::vector<clang::clangd::CallHierarchyIncomingCall>> callers_per_item{
+            extractor_.find_callers_per_item(frontier)};
+        // clang-format off
+        return callers_per_item
+               | ranges::views::transform([](std::vector<clang::clangd::CallHierarchyIncomingCall> const& callers) {
+                   return callers
+                          | ranges::views::transform([](clang::clangd::CallHierarchyIncomingCall const& caller) {
+                              return caller.from;
+                            })
+                          | ranges::to<std::vector>();
+                 })
+               | ranges::to<std::vector>();
+        // clang-format on
+      },
+      [this](std::vector<clang::clangd::CallHierarchyItem> const& callers) { return query_items(*this, callers); },
+      edge_type,
+      reverse_edge,
+      walk_budget,
+      output);
 }
 
 [[nodiscard]] auto Referencer::find_direct_supertypes(Reference const& reference) -> std::vector<Reference> {
   auto [file, pos]{to_file_pos(*find_preferred_declaration(reference))};
-  std::vector<clang::clangd::TypeHierarchyItem> supertypes{
-      extractor_.find_supertypes(extractor_.prepare_type_hierarchy(file, pos))};
-  // clang-format off
-  return supertypes
-         | ranges::views::transform([this](clang::clangd::TypeHierarchyItem const& supertype) {
-             return to_reference(*this, supertype);
-           })
-         | ranges::to<std::vector>();
-  // clang-format on
+  return to_references(*this, extractor_.find_supertypes(extractor_.prepare_type_hierarchy(file, pos)));
 }
 
-namespace {
-  void find_supertypes_impl(Referencer& referencer,  //  NOLINT(*recursion*)
-                            Reference_tree& result,
-                            clang::clangd::TypeHierarchyItem item) {
-    result.reference = to_reference(referencer, item);
-    for (auto subtype : referencer.extractor().find_supertypes(std::vector{std::move(item)})) {
-      Reference_tree child;
-      find_supertypes_impl(referencer, child, std::move(subtype));
-      result.children.emplace_back(std::move(child));
+void Referencer::find_supertype_hierarchies(Reference const& reference,
+                                            Reference_graph_builder& output,
+                                            Edge_type edge_type,
+                                            bool reverse_edge,
+                                            Walk_budget* budget) {
+  Walk_budget own_budget{options_};
+  Walk_budget& walk_budget{budget != nullptr ? *budget : own_budget};
+  Reference root{*find_preferred_declaration(reference)};
+
+  if (options_.index_only && root.symbol_id) {
+    std::vector<clang::clangd::Symbol> symbols{extractor_.lookup_index_symbols({root.symbol_id})};
+    if (!symbols.empty()) {
+      // Bases were read from the `BaseOf` relations when the index was loaded, so no type hierarchy is prepared
+      detail::find_hierarchies(
+          std::move(root),
+          std::move(symbols.front()),
+          [this](std::vector<clang::clangd::Symbol> const& frontier) {
+            return extractor_.find_index_supertypes_per_id(to_ids(frontier));
+          },
+          [this](std::vector<clang::clangd::Symbol> const& supertypes) {
+            return supertypes
+                   | ranges::views::transform(
+                       [this](clang::clangd::Symbol const& supertype) { return to_index_reference(supertype); })
+                   | ranges::to<std::vector>();
+          },
+          edge_type,
+          reverse_edge,
+          walk_budget,
+          output);
+      return;
     }
   }
-}  // namespace
 
-[[nodiscard]] auto Referencer::find_supertype_hierarchies(Reference const& reference) -> Reference_tree {
-  auto [file, pos]{to_file_pos(*find_preferred_declaration(reference))};
+  auto [file, pos]{to_file_pos(root)};
   std::vector<clang::clangd::TypeHierarchyItem> items{extractor_.prepare_type_hierarchy(file, pos)};
   assert(!items.empty());
 
-  Reference_tree result;
-  find_supertypes_impl(*this, result, items.front());
-  return result;
+  detail::find_hierarchies(
+      to_references(*this, std::vector{items.front()}).front(),
+      items.front(),
+      [this](std::vector<clang::clangd::TypeHierarchyItem> const& frontier) {
+        return extractor_.find_supertypes_per_item(frontier);
+      },
+      [this](std::vector<clang::clangd::TypeHierarchyItem> const& types) { return query_items(*this, types); },
+      edge_type,
+      reverse_edge,
+      walk_budget,
+      output);
 }
 
 [[nodiscard]] auto Referencer::find_direct_subtypes(Reference const& reference) -> std::vector<Reference> {
   auto [file, pos]{to_file_pos(*find_preferred_declaration(reference))};
-  std::vector<clang::clangd::TypeHierarchyItem> supertypes{
-      extractor_.find_subtypes(extractor_.prepare_type_hierarchy(file, pos))};
-  // clang-format off
-  return supertypes
-         | ranges::views::transform([this](clang::clangd::TypeHierarchyItem const& subtypes) {
-             return to_reference(*this, subtypes);
-           })
-         | ranges::to<std::vector>();
-  // clang-format on
+  return to_references(*this, extractor_.find_subtypes(extractor_.prepare_type_hierarchy(file, pos)));
 }
 
-namespace {
-  void find_subtypes_impl(Referencer& referencer,  //  NOLINT(*recursion*)
-                          Reference_tree& result,
-                          clang::clangd::TypeHierarchyItem item) {
-    result.reference = to_reference(referencer, item);
-    for (auto subtype : referencer.extractor().find_subtypes(std::vector{std::move(item)})) {
-      Reference_tree child;
-      find_subtypes_impl(referencer, child, std::move(subtype));
-      result.children.emplace_back(std::move(child));
+void Referencer::find_subtype_hierarchies(Reference const& reference,
+                                          Reference_graph_builder& output,
+                                          Edge_type edge_type,
+                                          bool reverse_edge,
+                                          Walk_budget* budget) {
+  Walk_budget own_budget{options_};
+  Walk_budget& walk_budget{budget != nullptr ? *budget : own_budget};
+  Reference root{*find_preferred_declaration(reference)};
+
+  if (options_.index_only && root.symbol_id) {
+    std::vector<clang::clangd::Symbol> symbols{extractor_.lookup_index_symbols({root.symbol_id})};
+    if (!symbols.empty()) {
+      detail::find_hierarchies(
+          std::move(root),
+          std::move(symbols.front()),
+          [this](std::vector<clang::clangd::Symbol> const& frontier) {
+            return extractor_.find_index_subtypes_per_id(to_ids(frontier));
+          },
+          [this](std::vector<clang::clangd::Symbol> const& subtypes) {
+            return subtypes
+                   | ranges::views::transform(
+                       [this](clang::clangd::Symbol const& subtype) { return to_index_reference(subtype); })
+                   | ranges::to<std::vector>();
+          },
+          edge_type,
+          reverse_edge,
+          walk_budget,
+          output);
+      return;
     }
   }
-}  // namespace
 
-[[nodiscard]] auto Referencer::find_subtype_hierarchies(Reference const& reference) -> Reference_tree {
-  auto [file, pos]{to_file_pos(*find_preferred_declaration(reference))};
+  auto [file, pos]{to_file_pos(root)};
   std::vector<clang::clangd::TypeHierarchyItem> items{extractor_.prepare_type_hierarchy(file, pos)};
   assert(!items.empty());
 
-  Reference_tree result;
-  find_subtypes_impl(*this, result, items.front());
-  return result;
+  detail::find_hierarchies(
+      to_references(*this, std::vector{items.front()}).front(),
+      items.front(),
+      [this](std::vector<clang::clangd::TypeHierarchyItem> const& frontier) {
+        return extractor_.find_subtypes_per_item(frontier);
+      },
+      [this](std::vector<clang::clangd::TypeHierarchyItem> const& types) { return query_items(*this, types); },
+      edge_type,
+      reverse_edge,
+      walk_budget,
+      output);
 }
 }  // namespace cppcia
\ No newline at end of file
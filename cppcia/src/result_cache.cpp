@@ -0,0 +1,133 @@
+#include "cppcia/result_cache.hpp"
+
+#include "cppcia/binary_graph.hpp"
+#include "cppcia/frozen_graph.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <clangd/support/Logger.h>
+#include <fmt/core.h>
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/xxhash.h>
+
+namespace cppcia {
+namespace {
+  [[nodiscard]] auto write_atomically(std::filesystem::path const& file,
+                                      llvm::function_ref<void(std::ostream&)> write) -> bool {
+    llvm::SmallString<128> temporary;
+    llvm::sys::fs::createUniquePath(file.string() + ".%%%%%%%%.tmp", temporary, /*MakeAbsolute=*/false);
+    std::error_code error;
+    {
+      std::ofstream ofile{temporary.str().str(), std::ios::out | std::ios::binary};
+      write(ofile);
+      if (!ofile.flush()) {
+        error = std::make_error_code(std::errc::io_error);
+      }
+    }
+    if (!error) {
+      std::filesystem::rename(temporary.str().str(), file, error);
+    }
+    if (error) {
+      std::error_code ignored;
+      std::filesystem::remove(temporary.str().str(), ignored);
+      clang::clangd::elog("Failed to cache {0}: {1}", file.string(), error.message());
+      return false;
+    }
+    return true;
+  }
+}  // namespace
+
+void Cache_key::add(std::string_view part) {
+  auto const size{static_cast<std::uint64_t>(part.size())};
+  std::array<std::uint8_t, sizeof(size)> size_bytes{};
+  std::memcpy(size_bytes.data(), &size, sizeof(size));
+  sha256_.update(size_bytes);
+  sha256_.update(llvm::StringRef{part.data(), part.size()});
+}
+
+void Cache_key::add_file(std::filesystem::path const& file) {
+  add(content_digest(file).value_or("missing"));
+}
+
+auto Cache_key::digest() && -> std::string {
+  return llvm::toHex(sha256_.final(), /*LowerCase=*/true);
+}
+
+auto content_digest(std::filesystem::path const& file) -> std::optional<std::string> {
+  auto buffer{llvm::MemoryBuffer::getFile(file.string(), /*IsText=*/false, /*RequiresNullTerminator=*/false)};
+  if (!buffer) {
+    return std::nullopt;
+  }
+  auto const content{(*buffer)->getBuffer()};
+  return fmt::format("{:016x}{:016x}", llvm::xxh3_64bits(llvm::arrayRefFromStringRef(content)), content.size());
+}
+
+auto Result_cache::lookup(std::string_view key) const -> std::optional<Mapped_reference_graph> {
+  auto sources{llvm::MemoryBuffer::getFile(sources_file(key).string(), /*IsText=*/true)};
+  if (!sources) {
+    return std::nullopt;
+  }
+
+  llvm::SmallVector<llvm::StringRef> lines;
+  (*sources)->getBuffer().split(lines, '\n', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (auto const line : lines) {
+    auto const [digest, file]{line.split(' ')};
+    if (content_digest(file.str()) != digest.str()) {
+      return std::nullopt;
+    }
+  }
+
+  try {
+    return Mapped_reference_graph{graph_file(key).string()};
+  } catch (std::runtime_error const& error) {
+    clang::clangd::elog("Ignored the cached graph {0}: {1}", graph_file(key).string(), error.what());
+    return std::nullopt;
+  }
+}
+
+void Result_cache::store(std::string_view key,
+                         Frozen_reference_graph const& graph,
+                         std::vector<std::string> const& sources) const {
+  std::string manifest;
+  for (auto const& source : sources) {
+    auto const digest{content_digest(source)};
+    if (!digest) {
+      // A result that depends on a file which can't be read can't be validated later
+      return;
+    }
+    manifest += fmt::format("{} {}\n", *digest, source);
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(directory_, error);
+  if (error) {
+    clang::clangd::elog("Failed to create the cache directory {0}: {1}", directory_.string(), error.message());
+    return;
+  }
+
+  // An entry is complete once its sources are there, so they are removed before and written after the graph
+  std::filesystem::remove(sources_file(key), error);
+  if (write_atomically(graph_file(key), [&graph](std::ostream& ostream) { write_binary(ostream, graph); })) {
+    [[maybe_unused]] auto const stored{
+        write_atomically(sources_file(key), [&manifest](std::ostream& ostream) { ostream << manifest; })};
+  }
+}
+}  // namespace cppcia
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "cppcia/server.hpp"
+
+#include "cppcia/extractor.hpp"
+#include "cppcia/frozen_graph.hpp"
+#include "cppcia/json.hpp"
+#include "cppcia/reference.hpp"
+
+#include <exception>
+#include <filesystem>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+
+namespace cppcia {
+namespace {
+  [[nodiscard]] auto parse(std::string const& line) -> nlohmann::json {
+    try {
+      return nlohmann::json::parse(line);
+    } catch (nlohmann::json::parse_error const& error) {
+      throw Rpc_exception{Rpc_error::parse_error, error.what()};
+    }
+  }
+
+  // Notifications, i.e. requests without an id, are not answered
+  void respond(nlohmann::json const& id, nlohmann::json result, std::ostream& ostream) {
+    if (id.is_null()) {
+      return;
+    }
+    ostream << nlohmann::json{{"jsonrpc", "2.0"}, {"id", id}, {"result", std::move(result)}} << '\n';
+  }
+
+  void respond_error(nlohmann::json const& id, Rpc_error code, std::string_view message, std::ostream& ostream) {
+    ostream << nlohmann::json{{"jsonrpc", "2.0"},
+                              {"id", id},
+                              {"error", {{"code", static_cast<int>(code)}, {"message", message}}}}
+            << '\n';
+  }
+}  // namespace
+
+void Server::serve(std::istream& istream, std::ostream& ostream) {
+  std::string line;
+  while (!exiting_ && std::getline(istream, line)) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+      continue;
+    }
+    handle(line, ostream);
+    ostream.flush();
+  }
+}
+
+void Server::handle(std::string const& line, std::ostream& ostream) {
+  nlohmann::json id{nullptr};
+  try {
+    auto const message{parse(line)};
+    if (message.contains("id")) {
+      id = message.at("id");
+    }
+    if (!message.is_object() || !message.contains("method") || !message.at("method").is_string()) {
+      throw Rpc_exception{Rpc_error::invalid_request, "A request must be an object with a string \"method\""};
+    }
+    auto const params{message.value("params", nlohmann::json::object())};
+    if (!params.is_object()) {
+      throw Rpc_exception{Rpc_error::invalid_params, "\"params\" must be an object"};
+    }
+
+    auto const& method{message.at("method").get_ref<std::string const&>()};
+    if (method == "impact") {
+      impact(id, params, ostream);
+    } else if (method == "update_file") {
+      update_file(params);
+      respond(id, nullptr, ostream);
+    } else if (method == "exit") {
+      exiting_ = true;
+      respond(id, nullptr, ostream);
+    } else {
+      throw Rpc_exception{Rpc_error::method_not_found, fmt::format("Unknown method \"{}\"", method)};
+    }
+  } catch (Rpc_exception const& exception) {
+    respond_error(id, exception.code(), exception.what(), ostream);
+  } catch (std::invalid_argument const& exception) {
+    respond_error(id, Rpc_error::invalid_params, exception.what(), ostream);
+  } catch (std::exception const& exception) {
+    respond_error(id, Rpc_error::internal_error, exception.what(), ostream);
+  }
+}
+
+// The graph is built before anything is written, so that a failed query still gets a well-formed error
+void Server::impact(nlohmann::json const& id, nlohmann::json const& params, std::ostream& ostream) {
+  if (id.is_null()) {
+    return;  // The result of a notification would be dropped anyway
+  }
+  auto const graph{impact_(params)};
+
+  ostream << R"({"jsonrpc":"2.0","id":)" << id << R"(,"result":)";
+  Json_sink<Reference, Edge_type, Reference_json_writer, decltype(edge_type_json_writer)> sink{
+      ostream, Json_style::inline_array, Reference_json_writer{workspace_root_}, edge_type_json_writer};
+  send_to(sink, graph);
+  sink.finish();
+  ostream << "}\n";
+}
+
+// An overlay doesn't need the file to exist on disk, e.g. for a file not saved yet
+void Server::update_file(nlohmann::json const& params) {
+  if (!params.contains("file") || !params.at("file").is_string()) {
+    throw Rpc_exception{Rpc_error::invalid_params, "\"file\" must be a string"};
+  }
+  auto const file{std::filesystem::absolute(params.at("file").get<std::string>()).string()};
+  if (params.contains("content")) {
+    if (!params.at("content").is_string()) {
+      throw Rpc_exception{Rpc_error::invalid_params, "\"content\" must be a string"};
+    }
+    referencer_->update_file(file, params.at("content").get_ref<std::string const&>());
+    return;
+  }
+  if (!std::filesystem::exists(file)) {
+    throw std::invalid_argument{fmt::format("Path {} doesn't exist!", file)};
+  }
+  referencer_->update_file(file, read_file(file));
+}
+}  // namespace cppcia
\ No newline at end of file
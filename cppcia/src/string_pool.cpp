@@ -0,0 +1,30 @@
+#include "cppcia/string_pool.hpp"
+
+#include <mutex>
+#include <string_view>
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Allocator.h>
+#include <llvm/Support/StringSaver.h>
+
+namespace cppcia {
+namespace {
+  class String_pool {
+   public:
+    [[nodiscard]] auto intern(std::string_view string) -> std::string_view {
+      std::scoped_lock const lock{mutex_};
+      return saver_.save(llvm::StringRef{string.data(), string.size()});
+    }
+
+   private:
+    std::mutex mutex_;
+    llvm::BumpPtrAllocator allocator_;
+    llvm::UniqueStringSaver saver_{allocator_};
+  };
+}  // namespace
+
+[[nodiscard]] auto intern(std::string_view string) -> std::string_view {
+  static String_pool pool;
+  return pool.intern(string);
+}
+}  // namespace cppcia
\ No newline at end of file
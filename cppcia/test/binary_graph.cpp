@@ -0,0 +1,122 @@
+#include "cppcia/binary_graph.hpp"
+#include "cppcia/frozen_graph.hpp"
+#include "cppcia/reference.hpp"
+#include "cppcia/string_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <gsl/gsl>
+#include <ios>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <clangd/Protocol.h>
+
+namespace cppcia {
+TEST_CASE("binary graph", "[binary_graph]") {
+  auto const path{std::filesystem::temp_directory_path() / "cppcia_test_binary_graph.bin"};
+
+  Reference file{make_file_reference("/foo.cpp")};
+  Reference symbol{file};
+  symbol.kind             = SymbolKind::Function;
+  symbol.name_range       = Range{.start{.line{1}, .character{5}}, .end{.line{1}, .character{8}}};
+  symbol.full_range       = Range{.start{.line{1}, .character{0}}, .end{.line{3}, .character{1}}};
+  symbol.namespace_scopes = Interned_string{"a::"};
+  symbol.local_scopes     = Interned_string{"Foo::"};
+  symbol.name             = Interned_string{"bar"};
+  symbol.truncated        = true;
+
+  Frozen_reference_graph const graph{
+      std::vector<Reference>{file, symbol},
+      std::vector<Frozen_reference_graph::Edge_entry>{{.source{1}, .target{0}, .edge{Edge_type::dotted}}}};
+  {
+    std::ofstream ofile{path, std::ios::out | std::ios::binary};
+    write_binary(ofile, graph);
+  }
+
+  Mapped_reference_graph const mapped{path.string()};
+  REQUIRE(mapped.vertex_count() == 2);
+  REQUIRE(mapped.edge_count() == 1);
+
+  CHECK(mapped.vertex(0) == file);
+  CHECK(!mapped.vertex(0).full_range);
+
+  auto const read_symbol{mapped.vertex(1)};
+  CHECK(read_symbol == symbol);
+  CHECK(read_symbol.full_range == symbol.full_range);
+  CHECK(read_symbol.namespace_scopes == symbol.namespace_scopes);
+  CHECK(read_symbol.local_scopes == symbol.local_scopes);
+  CHECK(read_symbol.name == symbol.name);
+  CHECK(read_symbol.truncated);
+
+  CHECK(mapped.targets(0).empty());
+  REQUIRE(mapped.targets(1).size() == 1);
+  CHECK(mapped.targets(1).front() == 0);
+  CHECK(mapped.edge_types(1).front() == Edge_type::dotted);
+
+  auto const frozen{mapped.to_frozen()};
+  CHECK(frozen.vertex_count() == 2);
+  CHECK(frozen.edge_count() == 1);
+
+  {
+    std::ofstream ofile{path, std::ios::out | std::ios::binary};
+    ofile << "not a graph";
+  }
+  CHECK_THROWS_AS(Mapped_reference_graph{path.string()}, std::runtime_error);
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("binary graph validation", "[binary_graph]") {
+  using namespace detail::binary;  // NOLINT(*using-namespace*)
+
+  auto const path{std::filesystem::temp_directory_path() / "cppcia_test_binary_graph_validation.bin"};
+
+  Reference file{make_file_reference("/foo.cpp")};
+  Reference symbol{file};
+  symbol.kind = SymbolKind::Function;
+  symbol.name = Interned_string{"bar"};
+
+  Frozen_reference_graph const graph{
+      std::vector<Reference>{file, symbol},
+      std::vector<Frozen_reference_graph::Edge_entry>{{.source{1}, .target{0}, .edge{Edge_type::dotted}}}};
+  std::ostringstream oss;
+  write_binary(oss, graph);
+  std::string const bytes{std::move(oss).str()};
+  Header header{};
+  std::memcpy(&header, bytes.data(), sizeof(Header));
+
+  // Writes the graph with `value` at `offset` and maps it
+  auto const map_with{[&bytes, &path](std::uint64_t offset, auto value) {
+    std::string corrupted{bytes};
+    std::memcpy(corrupted.data() + offset, &value, sizeof(value));  // NOLINT(*pointer-arithmetic*)
+    {
+      std::ofstream ofile{path, std::ios::out | std::ios::binary};
+      ofile << corrupted;
+    }
+    return Mapped_reference_graph{path.string()};
+  }};
+
+  CHECK_NOTHROW(map_with(offsetof(Header, byte_order), byte_order_mark));
+  CHECK_THROWS_AS(map_with(offsetof(Header, byte_order), std::uint32_t{0x04030201}), std::runtime_error);
+  CHECK_THROWS_AS(map_with(header.offsets_offset, std::uint64_t{1}), std::runtime_error);
+  CHECK_THROWS_AS(map_with(header.offsets_offset + sizeof(std::uint64_t), std::uint64_t{2}), std::runtime_error);
+  CHECK_THROWS_AS(map_with(header.offsets_offset + (2 * sizeof(std::uint64_t)), std::uint64_t{0}), std::runtime_error);
+  CHECK_THROWS_AS(map_with(header.targets_offset, std::uint32_t{2}), std::runtime_error);
+  CHECK_THROWS_AS(map_with(header.edge_types_offset, std::uint8_t{42}), std::runtime_error);
+  CHECK_THROWS_AS(map_with(header.vertices_offset + offsetof(Vertex_record, kind), std::uint32_t{1000}),
+                  std::runtime_error);
+  CHECK_THROWS_AS(map_with(header.vertices_offset + sizeof(Vertex_record) + offsetof(Vertex_record, name),
+                           String_ref{.offset{gsl::narrow_cast<std::uint32_t>(header.strings_size)}, .size{1}}),
+                  std::runtime_error);
+
+  std::filesystem::remove(path);
+}
+}  // namespace cppcia
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "cppcia/diff.hpp"
+
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace cppcia {
+TEST_CASE("merged", "[diff]") {
+  CHECK(merged({}).empty());
+  CHECK(merged({{.first{5}, .last{6}}, {.first{0}, .last{1}}, {.first{2}, .last{2}}, {.first{6}, .last{8}}})
+        == std::vector<Line_range>{{.first{0}, .last{2}}, {.first{5}, .last{8}}});
+}
+
+TEST_CASE("intersects", "[diff]") {
+  std::vector<Line_range> const ranges{{.first{2}, .last{3}}, {.first{7}, .last{7}}};
+  CHECK(intersects(ranges, 0, 2));
+  CHECK(intersects(ranges, 3, 5));
+  CHECK(intersects(ranges, 4, 10));
+  CHECK_FALSE(intersects(ranges, 0, 1));
+  CHECK_FALSE(intersects(ranges, 4, 6));
+  CHECK_FALSE(intersects(ranges, 8, 10));
+}
+
+TEST_CASE("parse_unified_diff", "[diff]") {
+  auto const file_diffs{parse_unified_diff(R"(diff --git a/foo.cpp b/foo.cpp
+--- a/foo.cpp
++++ b/foo.cpp
+@@ -1,3 +1,4 @@
+ a
++b
+ c
+ d
+@@ -10,2 +11 @@ void foo() {
+ x
+-y
+diff --git a/gone.cpp b/gone.cpp
+--- a/gone.cpp
++++ /dev/null
+@@ -1 +0,0 @@
+-z
+--- bar.cpp	2024-01-01 00:00:00
++++ bar.cpp	2024-01-02 00:00:00
+@@ -0,0 +1,2 @@
++--- not a header
++++ not a header either
+)")};
+
+  REQUIRE(file_diffs.size() == 2);
+  CHECK(file_diffs[0].file == "foo.cpp");
+  CHECK(file_diffs[0].changed_lines == std::vector<Line_range>{{.first{1}, .last{1}}, {.first{11}, .last{11}}});
+  CHECK(file_diffs[1].file == "bar.cpp");
+  CHECK(file_diffs[1].changed_lines == std::vector<Line_range>{{.first{0}, .last{1}}});
+}
+}  // namespace cppcia
\ No newline at end of file
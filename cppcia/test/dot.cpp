@@ -1,4 +1,5 @@
 #include "cppcia/dot.hpp"
+#include "cppcia/reference.hpp"
 
 #include <sstream>
 #include <string>
@@ -36,4 +37,19 @@ TEST_CASE("format_to_in_dot", "[.dot]") {
 }
 )dot");
 }
+
+TEST_CASE("Reference_writer", "[dot]") {
+  Reference reference{make_file_reference("/foo.cpp")};
+  Reference_writer const writer{"/"};
+
+  CHECK(writer(0, reference).find("truncated") == std::string::npos);
+
+  reference.truncated = true;
+  std::string const label{writer(0, reference)};
+  CHECK(label.find("truncated") != std::string::npos);
+  CHECK(label.find("foo.cpp") != std::string::npos);
+
+  // Cached paths and the reused buffer make no difference
+  CHECK(writer(0, reference) == label);
+}
 }  // namespace cppcia
\ No newline at end of file
@@ -3,14 +3,23 @@
 #include "cppcia/test/annotations.hpp"
 #include "cppcia/test/extractor.hpp"
 
+#include <optional>
+#include <set>
+#include <string>
 #include <vector>
 
 #include <catch2/catch_test_macros.hpp>
+#include <clang/Index/IndexSymbol.h>
 #include <clangd/ClangdServer.h>
+#include <clangd/Hover.h>
 #include <clangd/Protocol.h>
+#include <clangd/index/Ref.h>
+#include <clangd/index/Relation.h>
+#include <clangd/index/Symbol.h>
 #include <clangd/support/Logger.h>
 #include <clangd/support/Path.h>
 #include <clangd/support/ThreadsafeFS.h>
+#include <llvm/ADT/StringRef.h>
 #include <magic_enum/magic_enum.hpp>
 
 namespace cppcia {
@@ -29,4 +38,105 @@ TEST_CASE("query_name", "[extractor]") {
   CHECK(symbols[1].name == "value2");
   CHECK(symbols[1].kind == clang::clangd::SymbolKind::Variable);
 }
+
+TEST_CASE("update_file", "[extractor]") {
+  Extractor extractor{make_extractor_for_test()};
+  Mock_file file{"foo.cpp", Annotations{R"cpp(
+                                          int value = 0;
+                                        )cpp"}};
+
+  CHECK(extractor.update_file(file.path(), file.annotations().code()));
+  CHECK_FALSE(extractor.update_file(file.path(), file.annotations().code()));
+  CHECK(extractor.update_file(file.path(), "int value = 1;"));
+}
+
+TEST_CASE("query_location_infos", "[extractor]") {
+  Extractor extractor{make_extractor_for_test()};
+  Mock_file file{"foo.cpp", Annotations{R"cpp(
+                                          int $1^value1    = 0;
+                                          double $2^value2 = 10;
+                                        )cpp"}};
+  extractor.update_file(file.path(), file.annotations().code());
+
+  std::vector<std::optional<clang::clangd::HoverInfo>> infos{
+      extractor.query_location_infos({{file.path().str(), file.annotations().point("1")},
+                                      {file.path().str(), file.annotations().point("2")}})};
+
+  REQUIRE(infos.size() == 2);
+  REQUIRE(infos[0].has_value());
+  CHECK(infos[0]->Name == "value1");
+  REQUIRE(infos[1].has_value());
+  CHECK(infos[1]->Name == "value2");
+}
+
+TEST_CASE("find_index_callers_per_id", "[extractor]") {
+  clang::clangd::Range const range{.start{.line{1}, .character{2}}, .end{.line{1}, .character{5}}};
+  auto const function{[&range](llvm::StringRef name, clang::clangd::PathRef file) {
+    return make_index_symbol(
+        "c:@F@" + name.str() + "#", "", name, clang::index::SymbolKind::Function, make_index_location(file, range));
+  }};
+  auto const callee{function("callee", "a.cpp")};
+  auto const caller1{function("caller1", "b.cpp")};
+  auto const caller2{function("caller2", "c.cpp")};
+  auto const other{function("other", "d.cpp")};
+
+  clang::clangd::Range const second_line{.start{.line{2}, .character{2}}, .end{.line{2}, .character{5}}};
+  Extractor extractor{make_extractor_for_test(make_index_for_test(
+      {callee, caller1, caller2, other},
+      {{callee.ID, make_index_ref(make_index_location("b.cpp", range), caller1.ID)},
+       {callee.ID, make_index_ref(make_index_location("b.cpp", second_line), caller1.ID)},
+       {callee.ID, make_index_ref(make_index_location("c.cpp", range), caller2.ID)},
+       {callee.ID, make_index_ref(make_index_location("d.cpp", range), other.ID, clang::clangd::RefKind::Declaration)},
+       {caller1.ID, make_index_ref(make_index_location("c.cpp", second_line), caller2.ID)}}))};
+
+  auto const callers_per_id{extractor.find_index_callers_per_id({callee.ID, caller1.ID, caller2.ID})};
+  REQUIRE(callers_per_id.size() == 3);
+
+  // Each container is reported once however many references it holds, and declarations are not calls
+  std::set<std::string> callee_callers;
+  for (auto const& caller : callers_per_id[0]) {
+    CHECK(callee_callers.insert(caller.Name.str()).second);
+  }
+  CHECK(callee_callers == std::set<std::string>{"caller1", "caller2"});
+
+  REQUIRE(callers_per_id[1].size() == 1);
+  CHECK(callers_per_id[1].front().ID == caller2.ID);
+  CHECK(callers_per_id[2].empty());
+}
+
+TEST_CASE("find_index_supertypes_per_id", "[extractor]") {
+  auto const type{[](llvm::StringRef name) {
+    return make_index_symbol("c:@S@" + name.str(),
+                             "",
+                             name,
+                             clang::index::SymbolKind::Class,
+                             make_index_location("foo.cpp", clang::clangd::Range{}));
+  }};
+  auto const base1{type("Base1")};
+  auto const base2{type("Base2")};
+  auto const derived{type("Derived")};
+  std::vector<clang::clangd::Relation> const relations{
+      {.Subject{base1.ID}, .Predicate{clang::clangd::RelationKind::BaseOf}, .Object{derived.ID}},
+      {.Subject{base2.ID}, .Predicate{clang::clangd::RelationKind::BaseOf}, .Object{derived.ID}},
+      {.Subject{base2.ID}, .Predicate{clang::clangd::RelationKind::OverriddenBy}, .Object{base1.ID}}};
+
+  clang::clangd::RelationSlab::Builder builder;
+  for (auto const& relation : relations) {
+    builder.insert(relation);
+  }
+  Base_map bases{make_base_map(std::move(builder).build())};
+  CHECK(bases.size() == 1);
+
+  Extractor extractor{
+      make_extractor_for_test(make_index_for_test({base1, base2, derived}, {}, relations), std::move(bases))};
+  auto const supertypes_per_id{extractor.find_index_supertypes_per_id({derived.ID, base1.ID})};
+  REQUIRE(supertypes_per_id.size() == 2);
+
+  std::set<std::string> derived_bases;
+  for (auto const& supertype : supertypes_per_id[0]) {
+    derived_bases.insert(supertype.Name.str());
+  }
+  CHECK(derived_bases == std::set<std::string>{"Base1", "Base2"});
+  CHECK(supertypes_per_id[1].empty());
+}
 }  // namespace cppcia
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "cppcia/frozen_graph.hpp"
+
+#include "cppcia/reference.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <graaflib/graph.h>
+
+namespace cppcia {
+TEST_CASE("freeze", "[frozen_graph]") {
+  auto graph{freeze(std::invoke([]() {
+    graaf::directed_graph<std::string, int> initer{};
+    auto vertex_1{initer.add_vertex("a")};
+    auto vertex_2{initer.add_vertex("b")};
+    auto vertex_3{initer.add_vertex("c")};
+
+    initer.add_edge(vertex_1, vertex_2, 1);
+    initer.add_edge(vertex_1, vertex_3, 2);
+    initer.add_edge(vertex_2, vertex_3, 3);
+
+    return initer;
+  }))};
+
+  CHECK(graph.vertex_count() == 3);
+  CHECK(graph.edge_count() == 3);
+  CHECK(graph.vertex(0) == "a");
+  CHECK(graph.targets(0).size() == 2);
+  CHECK(graph.targets(1).size() == 1);
+  CHECK(graph.targets(2).empty());
+}
+
+TEST_CASE("map frozen graph", "[frozen_graph]") {
+  // NOLINTBEGIN(*magic-number*)
+  Frozen_graph<int, int> const graph{
+      std::vector<int>{1, 2, 3, 4, 5, 6},
+      {{.source{0}, .target{2}, .edge{1}},
+       {.source{0}, .target{4}, .edge{3}},
+       {.source{2}, .target{4}, .edge{2}},
+       {.source{1}, .target{3}, .edge{3}},
+       {.source{0}, .target{1}, .edge{4}},
+       {.source{2}, .target{3}, .edge{5}}}
+  };
+  // NOLINTEND(*magic-number*)
+
+  auto mapped{map(graph, [](int value) { return value % 2 == 0; })};
+
+  CHECK(mapped.vertex_count() == 2);
+  CHECK(mapped.edge_count() == 1);
+}
+
+TEST_CASE("map frozen graph of truncated references", "[frozen_graph]") {
+  Reference first{make_file_reference("/foo.cpp")};
+  first.name_range = Range{.start{.line{1}, .character{0}}, .end{.line{1}, .character{3}}};
+  Reference second{make_file_reference("/foo.cpp")};
+  second.name_range = Range{.start{.line{2}, .character{0}}, .end{.line{2}, .character{3}}};
+  second.truncated  = true;
+  Frozen_reference_graph const graph{std::vector<Reference>{first, second},
+                                     std::vector<Frozen_reference_graph::Edge_entry>{}};
+
+  // A vertex is truncated if any vertex collapsed into it is
+  auto const mapped{parallel_map(
+      graph,
+      [](Reference const& reference) {
+        auto result{make_file_reference(reference.uri)};
+        result.truncated = reference.truncated;
+        return result;
+      },
+      2)};
+  REQUIRE(mapped.vertex_count() == 1);
+  CHECK(mapped.vertex(0).truncated);
+}
+}  // namespace cppcia
\ No newline at end of file
@@ -1,7 +1,12 @@
 #include "cppcia/graph_util.hpp"
 
+#include "cppcia/reference.hpp"
+
 #include <functional>
 #include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include <catch2/catch_test_macros.hpp>
 #include <graaflib/graph.h>
@@ -36,6 +41,104 @@ TEST_CASE("merge_by", "[graph_util]") {
   CHECK(self.edge_count() == 3);
 }
 
+TEST_CASE("Graph_builder", "[graph_util]") {
+  Graph_builder<std::string, int, graaf::graph_type::DIRECTED> builder{std::invoke([]() {
+    graaf::directed_graph<std::string, int> initer{};
+    auto vertex_1{initer.add_vertex("a")};
+    auto vertex_2{initer.add_vertex("b")};
+    auto vertex_3{initer.add_vertex("c")};
+
+    initer.add_edge(vertex_1, vertex_2, 1);
+    initer.add_edge(vertex_1, vertex_3, 2);
+
+    return initer;
+  })};
+
+  builder.merge(std::invoke([]() {
+    graaf::directed_graph<std::string, int> initer{};
+    auto vertex_1{initer.add_vertex("a")};
+    auto vertex_2{initer.add_vertex("b")};
+    auto vertex_3{initer.add_vertex("d")};
+
+    initer.add_edge(vertex_1, vertex_2, 3);
+    initer.add_edge(vertex_1, vertex_3, 4);
+
+    return initer;
+  }));
+  CHECK(builder.add_vertex("d") == builder.add_vertex("d"));
+
+  auto graph{std::move(builder).build()};
+  CHECK(graph.vertex_count() == 4);
+  CHECK(graph.edge_count() == 3);
+}
+
+TEST_CASE("Graph_builder with a sink", "[graph_util]") {
+  class Recorder final : public Graph_sink<std::string, int> {
+   public:
+    void add_vertex(graaf::vertex_id_t id, std::string const& vertex) override {
+      vertices.emplace_back(id, vertex);
+    }
+    void add_edge(graaf::vertex_id_t source, graaf::vertex_id_t target, int const& edge) override {
+      edges.emplace_back(source, target, edge);
+    }
+
+    // NOLINTBEGIN(*non-private-member*)
+    std::vector<std::pair<graaf::vertex_id_t, std::string>> vertices;
+    std::vector<std::tuple<graaf::vertex_id_t, graaf::vertex_id_t, int>> edges;
+    // NOLINTEND(*non-private-member*)
+  };
+
+  Recorder recorder;
+  Graph_builder<std::string, int, graaf::graph_type::DIRECTED> builder{recorder};
+  auto vertex_1{builder.add_vertex("a")};
+  auto vertex_2{builder.add_vertex("b")};
+  builder.add_edge(vertex_1, vertex_2, 1);
+  CHECK(recorder.vertices.size() == 2);
+  CHECK(recorder.edges.size() == 1);
+
+  CHECK(builder.add_vertex("a") == vertex_1);
+  builder.add_edge(vertex_1, vertex_2, 2);
+  builder.add_edge(vertex_2, vertex_1, 3);
+  CHECK(recorder.vertices.size() == 2);
+  REQUIRE(recorder.edges.size() == 2);
+  CHECK(recorder.edges.front() == std::tuple{vertex_1, vertex_2, 1});
+  CHECK(recorder.edges.back() == std::tuple{vertex_2, vertex_1, 3});
+
+  CHECK(std::move(builder).build().vertex_count() == 0);
+}
+
+TEST_CASE("Graph_builder of truncated references", "[graph_util]") {
+  Reference cut_off{make_file_reference("/foo.cpp")};
+  cut_off.truncated = true;
+  Reference expanded{make_file_reference("/foo.cpp")};
+  expanded.expanded = true;
+  Reference const unwalked{make_file_reference("/foo.cpp")};
+
+  // A copy expanded by any walk wins, whichever is merged first
+  for (auto const& copies : {std::vector<Reference>{cut_off, expanded}, std::vector<Reference>{expanded, cut_off}}) {
+    Reference_graph_builder builder;
+    for (auto const& copy : copies) {
+      builder.add_vertex(copy);
+    }
+    REQUIRE(builder.graph().vertex_count() == 1);
+    for (auto const& [id, vertex] : builder.graph().get_vertices()) {
+      CHECK_FALSE(vertex.truncated);
+    }
+  }
+
+  // A copy no walk reached doesn't hide that another was cut off
+  for (auto const& copies : {std::vector<Reference>{cut_off, unwalked}, std::vector<Reference>{unwalked, cut_off}}) {
+    Reference_graph_builder builder;
+    for (auto const& copy : copies) {
+      builder.add_vertex(copy);
+    }
+    REQUIRE(builder.graph().vertex_count() == 1);
+    for (auto const& [id, vertex] : builder.graph().get_vertices()) {
+      CHECK(vertex.truncated);
+    }
+  }
+}
+
 TEST_CASE("merge", "[graph_util]") {
   auto graph{merge(std::invoke([]() {
                      graaf::directed_graph<std::string, int> initer{};
@@ -147,4 +250,49 @@ TEST_CASE("map", "[graph_util]") {
   CHECK(graph.vertex_count() == 2);
   CHECK(graph.edge_count() == 0);
 }
+
+TEST_CASE("map of truncated references", "[graph_util]") {
+  Reference_graph graph;
+  Reference first{make_file_reference("/foo.cpp")};
+  first.name_range = Range{.start{.line{1}, .character{0}}, .end{.line{1}, .character{3}}};
+  Reference second{make_file_reference("/foo.cpp")};
+  second.name_range = Range{.start{.line{2}, .character{0}}, .end{.line{2}, .character{3}}};
+  second.truncated  = true;
+  graph.add_vertex(first);
+  graph.add_vertex(second);
+
+  // A vertex is truncated if any vertex collapsed into it is
+  auto const mapped{map(graph, [](Reference const& reference) {
+    auto result{make_file_reference(reference.uri)};
+    result.truncated = reference.truncated;
+    return result;
+  })};
+  REQUIRE(mapped.vertex_count() == 1);
+  for (auto const& [id, vertex] : mapped.get_vertices()) {
+    CHECK(vertex.truncated);
+  }
+}
+
+TEST_CASE("parallel_map", "[graph_util]") {
+  auto graph{parallel_map(std::invoke([]() {
+                            graaf::directed_graph<int, int> initer{};
+                            // NOLINTBEGIN(*magic-number*)
+                            auto vertex_1{initer.add_vertex(1)};
+                            auto vertex_2{initer.add_vertex(2)};
+                            auto vertex_3{initer.add_vertex(3)};
+                            auto vertex_4{initer.add_vertex(4)};
+                            // NOLINTEND(*magic-number*)
+
+                            initer.add_edge(vertex_1, vertex_2, 1);
+                            initer.add_edge(vertex_3, vertex_4, 2);
+                            initer.add_edge(vertex_1, vertex_3, 3);
+
+                            return initer;
+                          }),
+                          [](int value) { return value % 2 == 0; },
+                          2)};
+
+  CHECK(graph.vertex_count() == 2);
+  CHECK(graph.edge_count() == 1);
+}
 }  // namespace cppcia
\ No newline at end of file
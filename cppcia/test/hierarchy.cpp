@@ -0,0 +1,232 @@
+#include "cppcia/detail/hierarchy.hpp"
+
+#include "cppcia/graph_util.hpp"
+#include "cppcia/reference.hpp"
+#include "cppcia/referencer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <clangd/index/SymbolID.h>
+#include <graaflib/types.h>
+
+namespace cppcia {
+namespace {
+  using Adjacency = std::map<int, std::vector<int>>;
+
+  struct Walk {
+   public:
+    // NOLINTBEGIN(*non-private-member*)
+    Reference_graph graph;
+    std::vector<int> expanded;  // Every node passed to `find_next_per_item`, sorted
+    // NOLINTEND(*non-private-member*)
+  };
+
+  [[nodiscard]] auto node_reference(int node) -> Reference {
+    return make_file_reference("/" + std::to_string(node) + ".cpp");
+  }
+
+  // Walks `adjacency` from `root`, each node standing for both the item and the reference of a symbol
+  [[nodiscard]] auto walk(Adjacency const& adjacency, Walk_budget& budget, int root = 0) -> Walk {
+    Walk result;
+    Reference_graph_builder output;
+    detail::find_hierarchies(
+        node_reference(root),
+        root,
+        [&adjacency, &result](std::vector<int> const& frontier) {
+          std::vector<std::vector<int>> next_per_node;
+          for (int node : frontier) {
+            result.expanded.push_back(node);
+            auto iter{adjacency.find(node)};
+            next_per_node.push_back(iter == adjacency.end() ? std::vector<int>{} : iter->second);
+          }
+          return next_per_node;
+        },
+        [](std::vector<int> const& nodes) {
+          std::vector<std::optional<Reference>> references;
+          for (int node : nodes) {
+            references.emplace_back(node_reference(node));
+          }
+          return references;
+        },
+        Edge_type::solid,
+        false,
+        budget,
+        output);
+    result.graph = std::move(output).build();
+    std::sort(result.expanded.begin(), result.expanded.end());
+    return result;
+  }
+
+  // Records what a sink-backed builder passes on, checking that every edge comes after both of its vertices
+  class Recorder final : public Graph_sink<Reference, Edge_type> {
+   public:
+    void add_vertex(graaf::vertex_id_t id, Reference const& vertex) override {
+      CHECK(id == vertices.size());
+      vertices.push_back(vertex);
+    }
+
+    void add_edge(graaf::vertex_id_t source, graaf::vertex_id_t target, Edge_type const& /*edge*/) override {
+      CHECK(source < vertices.size());
+      CHECK(target < vertices.size());
+      edges.emplace_back(source, target);
+    }
+
+    // NOLINTBEGIN(*non-private-member*)
+    std::vector<Reference> vertices;
+    std::vector<std::pair<graaf::vertex_id_t, graaf::vertex_id_t>> edges;
+    // NOLINTEND(*non-private-member*)
+  };
+
+  [[nodiscard]] auto is_truncated(Reference_graph const& graph, int node) -> bool {
+    for (auto const& [id, vertex] : graph.get_vertices()) {
+      if (vertex == node_reference(node)) {
+        return vertex.truncated;
+      }
+    }
+    FAIL("node " << node << " is not in the graph");
+    return false;
+  }
+}  // namespace
+
+TEST_CASE("find_hierarchies of a self-recursive symbol", "[hierarchy]") {
+  Walk_budget budget{Referencer_options{}};
+  Walk const result{walk({{0, {0}}}, budget)};
+
+  CHECK(result.graph.vertex_count() == 1);
+  CHECK(result.graph.edge_count() == 1);
+  CHECK(result.expanded == std::vector<int>{0});
+}
+
+TEST_CASE("find_hierarchies of a symbol located at another declaration", "[hierarchy]") {
+  // The root is located at the declaration of a recursive function, while the index locates it at its definition
+  clang::clangd::SymbolID const id{"c:@F@f#"};
+  Reference declaration{node_reference(0)};
+  declaration.symbol_id = id;
+  Reference definition{node_reference(1)};
+  definition.symbol_id = id;
+
+  Walk_budget budget{Referencer_options{}};
+  std::size_t expanded{0};
+  Reference_graph_builder output;
+  detail::find_hierarchies(
+      declaration,
+      0,
+      [&expanded](std::vector<int> const& frontier) {
+        expanded += frontier.size();
+        return std::vector<std::vector<int>>(frontier.size(), std::vector<int>{0});
+      },
+      [&definition](std::vector<int> const& nodes) {
+        return std::vector<std::optional<Reference>>(nodes.size(), definition);
+      },
+      Edge_type::solid,
+      false,
+      budget,
+      output);
+  Reference_graph const graph{std::move(output).build()};
+
+  CHECK(graph.vertex_count() == 1);
+  CHECK(graph.edge_count() == 1);
+  CHECK(expanded == 1);
+}
+
+TEST_CASE("find_hierarchies of a mutual cycle", "[hierarchy]") {
+  Walk_budget budget{Referencer_options{}};
+  Walk const result{walk({{0, {1}}, {1, {0}}}, budget)};
+
+  CHECK(result.graph.vertex_count() == 2);
+  CHECK(result.graph.edge_count() == 2);
+  CHECK(result.expanded == std::vector<int>{0, 1});
+}
+
+TEST_CASE("find_hierarchies of a diamond", "[hierarchy]") {
+  Walk_budget budget{Referencer_options{}};
+  Walk const result{walk({{0, {1, 2}}, {1, {3}}, {2, {3}}}, budget)};
+
+  CHECK(result.graph.vertex_count() == 4);
+  CHECK(result.graph.edge_count() == 4);
+  CHECK(result.expanded == std::vector<int>{0, 1, 2, 3});
+  for (auto const& [id, vertex] : result.graph.get_vertices()) {
+    CHECK_FALSE(vertex.truncated);
+    CHECK(vertex.expanded);
+  }
+}
+
+TEST_CASE("find_hierarchies out of depth", "[hierarchy]") {
+  Walk_budget budget{Referencer_options{.max_depth{1}}};
+  Walk const result{walk({{0, {1}}, {1, {2}}, {2, {3}}}, budget)};
+
+  CHECK(result.graph.vertex_count() == 2);
+  CHECK(result.expanded == std::vector<int>{0});
+  CHECK_FALSE(is_truncated(result.graph, 0));
+  CHECK(is_truncated(result.graph, 1));
+}
+
+TEST_CASE("find_hierarchies out of vertices", "[hierarchy]") {
+  Walk_budget budget{Referencer_options{.max_vertices{2}}};
+  Walk const first{walk({{0, {1, 2, 3}}}, budget)};
+
+  CHECK(first.graph.vertex_count() == 3);
+  CHECK(first.expanded == std::vector<int>{0});
+  CHECK(is_truncated(first.graph, 0));
+
+  // The vertices are shared by every walk drawing from the budget
+  Walk const second{walk({{4, {5}}}, budget, 4)};
+  CHECK(second.graph.vertex_count() == 1);
+  CHECK(second.expanded.empty());
+  CHECK(is_truncated(second.graph, 4));
+}
+
+TEST_CASE("find_hierarchies into a sink", "[hierarchy]") {
+  // Every vertex is passed on once, already marked with how its expansion ended
+  Recorder recorder;
+  Reference_graph_builder output{recorder};
+  Walk_budget budget{Referencer_options{.max_depth{2}}};
+  detail::find_hierarchies(
+      node_reference(0),
+      0,
+      [](std::vector<int> const& frontier) {
+        std::vector<std::vector<int>> next_per_node;
+        for (int node : frontier) {
+          next_per_node.push_back(node < 3 ? std::vector<int>{node + 1} : std::vector<int>{});
+        }
+        return next_per_node;
+      },
+      [](std::vector<int> const& nodes) {
+        std::vector<std::optional<Reference>> references;
+        for (int node : nodes) {
+          references.emplace_back(node_reference(node));
+        }
+        return references;
+      },
+      Edge_type::solid,
+      false,
+      budget,
+      output);
+
+  REQUIRE(recorder.vertices.size() == 3);
+  CHECK(recorder.vertices[0] == node_reference(0));
+  CHECK(recorder.vertices[0].expanded);
+  CHECK(recorder.vertices[1] == node_reference(1));
+  CHECK(recorder.vertices[1].expanded);
+  CHECK(recorder.vertices[2] == node_reference(2));
+  CHECK(recorder.vertices[2].truncated);
+  CHECK(recorder.edges == std::vector<std::pair<graaf::vertex_id_t, graaf::vertex_id_t>>{{0, 1}, {1, 2}});
+}
+
+TEST_CASE("find_hierarchies out of time", "[hierarchy]") {
+  Walk_budget budget{Referencer_options{.timeout{std::chrono::milliseconds{0}}}};
+  Walk const result{walk({{0, {1}}}, budget)};
+
+  CHECK(result.graph.vertex_count() == 1);
+  CHECK(result.expanded.empty());
+  CHECK(is_truncated(result.graph, 0));
+}
+}  // namespace cppcia
\ No newline at end of file
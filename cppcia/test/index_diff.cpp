@@ -0,0 +1,112 @@
+#include "cppcia/index_diff.hpp"
+
+#include "cppcia/test/extractor.hpp"
+
+#include <utility>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <clang/Index/IndexSymbol.h>
+#include <clangd/Protocol.h>
+#include <clangd/index/Ref.h>
+#include <clangd/index/Symbol.h>
+#include <clangd/index/SymbolID.h>
+#include <llvm/ADT/StringRef.h>
+
+namespace cppcia {
+namespace {
+  [[nodiscard]] auto make_symbol(llvm::StringRef usr, llvm::StringRef signature) -> clang::clangd::Symbol {
+    clang::clangd::Symbol result;
+    result.ID        = clang::clangd::SymbolID{usr};
+    result.Name      = usr;
+    result.Signature = signature;
+    return result;
+  }
+
+  [[nodiscard]] auto make_slab(std::vector<clang::clangd::Symbol> const& symbols) -> clang::clangd::SymbolSlab {
+    clang::clangd::SymbolSlab::Builder builder;
+    for (auto const& symbol : symbols) {
+      builder.insert(symbol);
+    }
+    return std::move(builder).build();
+  }
+}  // namespace
+
+TEST_CASE("diff_symbols", "[index_diff]") {
+  auto const old_symbols{
+      make_slab({make_symbol("kept", "()"), make_symbol("removed", "()"), make_symbol("changed", "(int)")})};
+  auto const new_symbols{
+      make_slab({make_symbol("kept", "()"), make_symbol("added", "()"), make_symbol("changed", "(long)")})};
+
+  auto const changes{diff_symbols(old_symbols, new_symbols)};
+  REQUIRE(changes.size() == 3);
+  for (auto const& changed : changes) {
+    if (changed.symbol->Name == "removed") {
+      CHECK(changed.change == Symbol_change::removed);
+    } else if (changed.symbol->Name == "added") {
+      CHECK(changed.change == Symbol_change::added);
+    } else {
+      CHECK(changed.symbol->Name == "changed");
+      CHECK(changed.change == Symbol_change::changed);
+      CHECK(changed.symbol->Signature == "(long)");
+    }
+  }
+
+  CHECK(diff_symbols(old_symbols, old_symbols).empty());
+}
+
+TEST_CASE("diff_symbols of moved declarations", "[index_diff]") {
+  auto const function_at{[](llvm::StringRef file, int first_line, int last_line) {
+    return make_index_symbol("c:@F@foo#",
+                             "",
+                             "foo",
+                             clang::index::SymbolKind::Function,
+                             make_index_location(file,
+                                                 clang::clangd::Range{.start{.line{first_line}, .character{0}},
+                                                                      .end{.line{last_line}, .character{1}}}));
+  }};
+  auto const old_symbols{make_slab({function_at("foo.cpp", 1, 3)})};
+
+  // Lines added above a declaration shift it without changing it
+  CHECK(diff_symbols(old_symbols, make_slab({function_at("foo.cpp", 5, 7)})).empty());
+
+  auto const moved_away{make_slab({function_at("bar.cpp", 1, 3)})};
+  REQUIRE(diff_symbols(old_symbols, moved_away).size() == 1);
+  CHECK(diff_symbols(old_symbols, moved_away).front().change == Symbol_change::changed);
+
+  auto const grown{make_slab({function_at("foo.cpp", 5, 8)})};
+  REQUIRE(diff_symbols(old_symbols, grown).size() == 1);
+  CHECK(diff_symbols(old_symbols, grown).front().change == Symbol_change::changed);
+}
+
+TEST_CASE("find_referrers_of_removed", "[index_diff]") {
+  auto const removed{make_symbol("removed", "()")};
+  auto const referrer{make_symbol("referrer", "()")};
+  auto const changed_referrer{make_symbol("changed_referrer", "(int)")};
+  auto const gone_referrer{make_symbol("gone_referrer", "()")};
+  auto const old_symbols{make_slab({removed, referrer, changed_referrer, gone_referrer})};
+  auto const new_symbols{make_slab({referrer, make_symbol("changed_referrer", "(long)")})};
+
+  auto const ref_from{[](clang::clangd::Symbol const& container, int line) {
+    clang::clangd::Range const range{.start{.line{line}, .character{0}}, .end{.line{line}, .character{1}}};
+    return make_index_ref(make_index_location("foo.cpp", range), container.ID);
+  }};
+  clang::clangd::RefSlab::Builder builder;
+  builder.insert(removed.ID, ref_from(referrer, 1));
+  builder.insert(removed.ID, ref_from(referrer, 2));
+  builder.insert(removed.ID, ref_from(changed_referrer, 3));
+  builder.insert(removed.ID, ref_from(gone_referrer, 4));
+  builder.insert(referrer.ID, ref_from(changed_referrer, 5));
+  auto const old_refs{std::move(builder).build()};
+
+  auto const changes{diff_symbols(old_symbols, new_symbols)};
+  REQUIRE(changes.size() == 3);
+
+  // Each referrer is reported once, while those changed or gone themselves are left to `diff_symbols`
+  auto const referrers{find_referrers_of_removed(changes, old_refs, new_symbols)};
+  REQUIRE(referrers.size() == 1);
+  CHECK(referrers.front().change == Symbol_change::changed);
+  CHECK(referrers.front().symbol->ID == referrer.ID);
+  CHECK(referrers.front().symbol == &*new_symbols.find(referrer.ID));
+}
+}  // namespace cppcia
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "cppcia/json.hpp"
+#include "cppcia/reference.hpp"
+
+#include <sstream>
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+#include <graaflib/types.h>
+#include <nlohmann/json.hpp>
+
+namespace cppcia {
+TEST_CASE("Json_sink", "[json]") {
+  auto const vertex_writer{[](graaf::vertex_id_t /*id*/, std::string const& vertex) {
+    return nlohmann::json{{"name", vertex}};
+  }};
+  auto const edge_writer{[](graaf::edge_id_t const& /*id*/, int edge) {
+    return nlohmann::json{{"weight", edge}};
+  }};
+
+  SECTION("array") {
+    std::ostringstream oss;
+    Json_sink<std::string, int, decltype(vertex_writer), decltype(edge_writer)> sink{
+        oss, Json_style::array, vertex_writer, edge_writer};
+    sink.add_vertex(0, "a");
+    sink.add_vertex(1, "b");
+    sink.add_edge(0, 1, 2);
+    sink.finish();
+
+    auto const records{nlohmann::json::parse(oss.str())};
+    REQUIRE(records.size() == 3);
+    CHECK(records[0] == nlohmann::json{{"type", "vertex"}, {"id", 0}, {"name", "a"}});
+    CHECK(records[2] == nlohmann::json{{"type", "edge"}, {"source", 0}, {"target", 1}, {"weight", 2}});
+  }
+
+  SECTION("empty array") {
+    std::ostringstream oss;
+    Json_sink<std::string, int, decltype(vertex_writer), decltype(edge_writer)> sink{
+        oss, Json_style::array, vertex_writer, edge_writer};
+    sink.finish();
+    CHECK(nlohmann::json::parse(oss.str()).empty());
+  }
+
+  SECTION("inline array") {
+    std::ostringstream oss;
+    Json_sink<std::string, int, decltype(vertex_writer), decltype(edge_writer)> sink{
+        oss, Json_style::inline_array, vertex_writer, edge_writer};
+    sink.add_vertex(0, "a");
+    sink.add_vertex(1, "b");
+    sink.add_edge(0, 1, 2);
+    sink.finish();
+
+    CHECK(oss.str().find('\n') == std::string::npos);
+    CHECK(nlohmann::json::parse(oss.str()).size() == 3);
+  }
+
+  SECTION("lines") {
+    std::ostringstream oss;
+    Json_sink<std::string, int, decltype(vertex_writer), decltype(edge_writer)> sink{
+        oss, Json_style::lines, vertex_writer, edge_writer};
+    sink.add_vertex(0, "a");
+    sink.add_vertex(1, "b");
+    sink.add_edge(0, 1, 2);
+    sink.finish();
+
+    std::istringstream iss{oss.str()};
+    std::string line;
+    int count{0};
+    while (std::getline(iss, line)) {
+      CHECK(nlohmann::json::parse(line).is_object());
+      ++count;
+    }
+    CHECK(count == 3);
+  }
+}
+
+TEST_CASE("Reference_json_writer", "[json]") {
+  Reference const reference{make_file_reference("/foo.cpp")};
+  auto const record{Reference_json_writer{}(0, reference)};
+
+  CHECK(record["kind"] == "File");
+  CHECK(record["file"] == "/foo.cpp");
+  CHECK(record["full_range"].is_null());
+  CHECK(record["truncated"] == false);
+}
+}  // namespace cppcia
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "cppcia/queries.hpp"
+
+#include "cppcia/reference.hpp"
+#include "cppcia/referencer.hpp"
+#include "cppcia/test/referencer.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <clangd/Protocol.h>
+#include <nlohmann/json.hpp>
+
+namespace cppcia {
+namespace {
+  [[nodiscard]] auto test_directory(std::string const& name) -> std::filesystem::path {
+    auto directory{std::filesystem::temp_directory_path() / name};
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory;
+  }
+}  // namespace
+
+TEST_CASE("parse_location", "[queries]") {
+  auto const [file, pos]{parse_location("/foo.cpp:1:2")};
+  CHECK(file == "/foo.cpp");
+  CHECK(pos == clang::clangd::Position{.line{1}, .character{2}});
+  CHECK_THROWS_AS(parse_location("/foo.cpp"), std::invalid_argument);
+}
+
+TEST_CASE("sorted_unique", "[queries]") {
+  CHECK(sorted_unique({" foo", "bar", "foo ", "bar"}) == std::vector<std::string>{"bar", "foo"});
+}
+
+TEST_CASE("json_queries", "[queries]") {
+  auto const queries{json_queries(nlohmann::json{{"names", {"foo", "bar"}}, {"old_indexes", {"old.idx"}}})};
+  CHECK(queries.files.empty());
+  CHECK(queries.names == std::vector<std::string>{"foo", "bar"});
+  CHECK(queries.old_indexes == std::vector<std::string>{"old.idx"});
+
+  CHECK_THROWS_AS(json_queries(nlohmann::json::array()), std::invalid_argument);
+  CHECK_THROWS_AS(json_queries(nlohmann::json{{"names", "foo"}}), std::invalid_argument);
+  CHECK_THROWS_AS(json_queries(nlohmann::json{{"names", {1, 2}}}), std::invalid_argument);
+}
+
+TEST_CASE("read_queries", "[queries]") {
+  auto const directory{test_directory("cppcia_test_queries")};
+  auto const file{(directory / "queries").string()};
+
+  SECTION("lines") {
+    std::ofstream{file} << "# comment\n"
+                           "\n"
+                           "file foo.cpp\n"
+                           "  location  foo.cpp:1:2\n"
+                           "name foo::bar\n"
+                           "name-fuzzy baz\n"
+                           "diff changes.diff\n"
+                           "old-index old.idx\n";
+    auto const queries{read_queries(file)};
+    CHECK(queries.files == std::vector<std::string>{"foo.cpp"});
+    CHECK(queries.locations == std::vector<std::string>{"foo.cpp:1:2"});
+    CHECK(queries.names == std::vector<std::string>{"foo::bar"});
+    CHECK(queries.names_fuzzy == std::vector<std::string>{"baz"});
+    CHECK(queries.diffs == std::vector<std::string>{"changes.diff"});
+    CHECK(queries.old_indexes == std::vector<std::string>{"old.idx"});
+  }
+
+  SECTION("an unknown kind") {
+    std::ofstream{file} << "file foo.cpp\n"
+                           "symbol foo\n";
+    CHECK_THROWS_AS(read_queries(file), std::invalid_argument);
+  }
+
+  SECTION("JSON") {
+    std::ofstream{file} << R"(  {"files": ["foo.cpp"], "names_fuzzy": ["baz"]})";
+    auto const queries{read_queries(file)};
+    CHECK(queries.files == std::vector<std::string>{"foo.cpp"});
+    CHECK(queries.names_fuzzy == std::vector<std::string>{"baz"});
+    CHECK(queries.names.empty());
+  }
+
+  SECTION("invalid JSON") {
+    std::ofstream{file} << R"({"files": ["foo.cpp")";
+    CHECK_THROWS_AS(read_queries(file), std::invalid_argument);
+  }
+
+  CHECK_THROWS_AS(read_queries((directory / "missing").string()), std::invalid_argument);
+}
+
+TEST_CASE("collect_seeds", "[queries]") {
+  auto const directory{test_directory("cppcia_test_collect_seeds")};
+  auto const foo{(directory / "foo.cpp").string()};
+  auto const bar{(directory / "bar.cpp").string()};
+  std::ofstream{foo} << "int foo();\n";
+  std::ofstream{bar} << "int bar();\n";
+  std::filesystem::create_directories(directory / "sub");
+  auto const foo_respelled{(directory / "." / "sub" / ".." / "foo.cpp").string()};
+  CHECK(canonical_file(foo_respelled) == canonical_file(foo));
+
+  auto const diff{(directory / "changes.diff").string()};
+  std::ofstream{diff} << "--- " << foo << "\n+++ " << foo << "\n@@ -1 +1 @@\n-int foo();\n+int foo(int);\n";
+
+  // Queries of one file are one seed however they're spelled, and duplicate names are one seed each
+  Queries const queries{.files{foo, foo_respelled},
+                        .locations{foo + ":0:4", foo_respelled + ":0:4", bar + ":0:4"},
+                        .names{"foo", " foo ", "bar"},
+                        .names_fuzzy{"foo"},
+                        .diffs{diff},
+                        .old_indexes{}};
+  CHECK(collect_seeds(queries, Impact_options{}).size() == 5);
+  CHECK(collect_seeds(Queries{}, Impact_options{}).empty());
+
+  Queries missing;
+  missing.files.push_back((directory / "missing.cpp").string());
+  CHECK_THROWS_AS(collect_seeds(missing, Impact_options{}), std::invalid_argument);
+}
+
+TEST_CASE("collect_seeds of changed lines", "[queries]") {
+  auto const directory{test_directory("cppcia_test_changed_lines")};
+  auto const file{(directory / "foo.cpp").string()};
+  std::string const code{"namespace a {\n"
+                         "struct Foo {\n"
+                         "  int bar() {\n"
+                         "    return 1;\n"
+                         "  }\n"
+                         "  int baz() { return 2; }\n"
+                         "};\n"
+                         "}  // namespace a\n"};
+  std::ofstream{file} << code;
+  auto const diff{(directory / "changes.diff").string()};
+  std::ofstream{diff} << "--- " << file << "\n+++ " << file << "\n@@ -4 +4 @@\n-    return 0;\n+    return 1;\n";
+
+  Referencer referencer{make_referencer_for_test()};
+  referencer.update_file(canonical_file(file), code);
+  Queries queries;
+  queries.diffs.push_back(diff);
+  auto const seeds{collect_seeds(queries, Impact_options{})};
+  REQUIRE(seeds.size() == 1);
+  Reference_graph_builder builder;
+  seeds.front()(referencer, builder);
+  Reference_graph const graph{std::move(builder).build()};
+
+  // The changed body line seeds its function only, not the class and namespace around it nor its sibling
+  REQUIRE(graph.vertex_count() != 0);
+  for (auto const& [id, vertex] : graph.get_vertices()) {
+    CHECK(vertex.name == "bar");
+  }
+}
+}  // namespace cppcia
\ No newline at end of file
@@ -39,12 +39,10 @@ TEST_CASE("referencer", "[.real]") {
   auto reference{referencer.query_location(file, {101, 21})};  // NOLINT(*magic-number*)
   REQUIRE(reference.has_value());
 
-  Reference_tree references{referencer.find_caller_hierarchies(*reference)};
+  Reference_graph references{referencer.find_caller_hierarchies(*reference, Edge_type::solid)};
 
   std::ofstream ofile{"/Users/feignclaims/code/cppcia/graph.dot"};
-  format_to_in_dot(ofile,
-                   to_graph(references, Edge_type::solid, /*reverse_edge=*/false),
-                   Reference_writer{"/Users/feignclaims/code/cpp/lefticus_cmake_template"});
+  format_to_in_dot(ofile, references, Reference_writer{"/Users/feignclaims/code/cpp/lefticus_cmake_template"});
 }
 
 TEST_CASE("find_type", "[.real]") {
@@ -57,7 +55,7 @@ TEST_CASE("find_type", "[.real]") {
   auto reference{referencer.query_location(file, {96, 18})};  // NOLINT(*magic-number*)
   REQUIRE(reference.has_value());
 
-  Reference_tree references{referencer.find_type(*reference), {}};
+  Reference_tree references{referencer.find_type(*reference)};
 
   std::ofstream ofile{"/Users/feignclaims/code/cppcia/graph.dot"};
   format_to_in_dot(ofile,
@@ -90,7 +88,7 @@ TEST_CASE("find_container", "[.real]") {
   auto reference{referencer.query_location(file, {95, 18})};  // NOLINT(*magic-number*)
   REQUIRE(reference.has_value());
 
-  Reference_tree references{referencer.find_container(*reference), {}};
+  Reference_tree references{referencer.find_container(*reference)};
 
   std::ofstream ofile{"/Users/feignclaims/code/cppcia/graph.dot"};
   format_to_in_dot(ofile,
@@ -108,7 +106,7 @@ TEST_CASE("find_container_tree", "[.real]") {
   auto reference{referencer.query_location(file, {95, 18})};  // NOLINT(*magic-number*)
   REQUIRE(reference.has_value());
 
-  Reference_tree references{referencer.find_container(*reference), {}};
+  Reference_tree references{referencer.find_container(*reference)};
 
   std::ofstream ofile{"/Users/feignclaims/code/cppcia/graph.dot"};
   format_to_in_dot(ofile,
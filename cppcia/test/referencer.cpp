@@ -1,16 +1,26 @@
 #include "cppcia/referencer.hpp"
 
+#include "cppcia/extractor.hpp"
 #include "cppcia/reference.hpp"
 #include "cppcia/test/annotations.hpp"
+#include "cppcia/test/extractor.hpp"
 #include "cppcia/test/referencer.hpp"
 
 #include <optional>
+#include <set>
+#include <string>
 #include <vector>
 
 #include <catch2/catch_test_macros.hpp>
+#include <clang/Index/IndexSymbol.h>
+#include <clangd/Protocol.h>
+#include <clangd/index/Relation.h>
+#include <clangd/index/SymbolID.h>
 #include <fmt/core.h>
 #include <fmt/ostream.h>
 #include <fmt/ranges.h>
+#include <llvm/ADT/StringRef.h>
+#include <range/v3/algorithm/any_of.hpp>
 
 namespace cppcia {
 TEST_CASE("query_location", "[referencer]") {
@@ -42,6 +52,28 @@ TEST_CASE("query_location", "[referencer]") {
   CHECK(reference->local_scopes == "Foo::");
 }
 
+TEST_CASE("query_location after update_file", "[referencer]") {
+  Referencer referencer{make_referencer_for_test()};
+  Mock_file file{"foo.cpp", Annotations{R"cpp(
+                                          int ^foo() { return 0; }
+                                        )cpp"}};
+  Mock_file updated_file{"foo.cpp", Annotations{R"cpp(
+                                          int ^bar() { return 0; }
+                                        )cpp"}};
+  REQUIRE(file.annotations().point() == updated_file.annotations().point());
+
+  referencer.update_file(file.path(), file.annotations().code());
+  std::optional<Reference> reference{referencer.query_location(file.path(), file.annotations().point())};
+  REQUIRE(reference.has_value());
+  CHECK(reference->name == "foo");
+  CHECK(referencer.query_location(file.path(), file.annotations().point()) == reference);
+
+  referencer.update_file(updated_file.path(), updated_file.annotations().code());
+  std::optional<Reference> updated{referencer.query_location(updated_file.path(), updated_file.annotations().point())};
+  REQUIRE(updated.has_value());
+  CHECK(updated->name == "bar");
+}
+
 TEST_CASE("query_name", "[referencer]") {
   Referencer referencer{make_referencer_for_test()};
   Mock_file file{"foo.cpp", Annotations{R"cpp(
@@ -70,6 +102,100 @@ TEST_CASE("query_name", "[referencer]") {
   // FIXME: Can't test index-based operations
 }
 
+TEST_CASE("query_symbol", "[referencer]") {
+  clang::clangd::Range const bar_range{.start{.line{3}, .character{7}}, .end{.line{3}, .character{10}}};
+  auto const namespace_a{make_index_symbol(
+      "c:@N@a", "", "a", clang::index::SymbolKind::Namespace, make_index_location("foo.cpp", clang::clangd::Range{}))};
+  auto const foo{make_index_symbol("c:@N@a@S@Foo",
+                                   "a::",
+                                   "Foo",
+                                   clang::index::SymbolKind::Class,
+                                   make_index_location("foo.cpp", clang::clangd::Range{}))};
+  auto const bar{make_index_symbol("c:@N@a@S@Foo@F@bar#",
+                                   "a::Foo::",
+                                   "bar",
+                                   clang::index::SymbolKind::InstanceMethod,
+                                   make_index_location("foo.cpp", bar_range))};
+  Referencer referencer{make_referencer_for_test(Referencer_options{.index_only{true}},
+                                                 make_index_for_test({namespace_a, foo, bar}, {}))};
+
+  std::optional<Reference> reference{referencer.query_symbol(bar)};
+  REQUIRE(reference.has_value());
+  CHECK(reference->kind == SymbolKind::Method);
+  CHECK(reference->uri.file() == test_path("foo.cpp"));
+  CHECK(reference->name_range == bar_range);
+  CHECK(reference->namespace_scopes == "a::");
+  CHECK(reference->local_scopes == "Foo::");
+  CHECK(reference->name == "bar");
+  CHECK(reference->symbol_id == bar.ID);
+}
+
+TEST_CASE("find_references with index_only", "[referencer]") {
+  Mock_file file{"foo.cpp", Annotations{R"cpp(
+                                          ^
+                                        )cpp"}};
+  clang::clangd::Range const in_foo{.start{.line{5}, .character{2}}, .end{.line{5}, .character{5}}};
+  clang::clangd::Range const in_bar{.start{.line{1}, .character{4}}, .end{.line{1}, .character{7}}};
+  clang::clangd::SymbolID const add_id{"c:@F@add#I#I#"};
+  clang::clangd::SymbolID const main_id{"c:@F@main#"};
+  Referencer referencer{make_referencer_for_test(
+      Referencer_options{.index_only{true}},
+      make_index_for_test({}, {{add_id, make_index_ref(make_index_location("foo.cpp", in_foo), main_id)},
+                               {add_id, make_index_ref(make_index_location("bar.cpp", in_bar), main_id)}}))};
+  referencer.update_file(file.path(), file.annotations().code());
+
+  // Nothing is declared in the file, so the root is resolved through the index alone
+  Reference root{make_file_reference(file.path())};
+  root.kind       = SymbolKind::Function;
+  root.name_range = clang::clangd::Range{.start{file.annotations().point()}, .end{file.annotations().point()}};
+  root.name       = Interned_string{"add"};
+  root.symbol_id  = add_id;
+
+  Reference_tree references{referencer.find_references(root)};
+  CHECK(references.root() == root);
+  auto children{references.children(Reference_tree::root_id)};
+  REQUIRE(children.size() == 2);
+  for (auto const& child : children) {
+    CHECK(child.reference.name == "add");
+    CHECK(child.reference.symbol_id == add_id);
+    CHECK(child.child_count == 0);
+  }
+  CHECK(ranges::any_of(children, [&](Reference_tree::Node const& child) {
+    return child.reference.uri.file() == test_path("foo.cpp") && child.reference.name_range == in_foo;
+  }));
+  CHECK(ranges::any_of(children, [&](Reference_tree::Node const& child) {
+    return child.reference.uri.file() == test_path("bar.cpp") && child.reference.name_range == in_bar;
+  }));
+}
+
+TEST_CASE("find_container", "[referencer]") {
+  Referencer referencer{make_referencer_for_test()};
+  Mock_file file{"foo.cpp", Annotations{R"cpp(
+                                          int a, b;
+                                          struct Foo {
+                                            void bar() {
+                                              int ^value = 0;
+                                            }
+                                            void baz() {}
+                                          };
+                                        )cpp"}};
+  referencer.update_file(file.path(), file.annotations().code());
+
+  std::optional<Reference> reference{referencer.query_location(file.path(), file.annotations().point())};
+  REQUIRE(reference.has_value());
+
+  CHECK(referencer.find_container(*reference).name == "bar");
+
+  Reference_tree path{referencer.find_container_path(*reference)};
+  CHECK(path.root().kind == SymbolKind::File);
+  auto containers{path.children(Reference_tree::root_id)};
+  REQUIRE(containers.size() == 1);
+  CHECK(containers[0].reference.name == "Foo");
+  auto contained{path.children(containers[0])};
+  REQUIRE(contained.size() == 1);
+  CHECK(contained[0].reference.name == "bar");
+}
+
 TEST_CASE("find_references", "[referencer]") {
   Referencer referencer{make_referencer_for_test()};
   // clang-format off
@@ -89,7 +215,10 @@ TEST_CASE("find_references", "[referencer]") {
   std::optional<Reference> reference{referencer.query_location(file.path(), file.annotations().point("main"))};
   REQUIRE(reference.has_value());
 
-  auto [root, children]{referencer.find_references(*reference)};
+  Reference_tree references{referencer.find_references(*reference)};
+  Reference const& root{references.root()};
+  auto children{references.children(Reference_tree::root_id)};
+  REQUIRE(children.size() == 2);
   CHECK(root.name_range.contains(file.annotations().point("main")));
   CHECK(root.uri.file() == file.path());
   CHECK(root.namespace_scopes.empty());
@@ -101,14 +230,14 @@ TEST_CASE("find_references", "[referencer]") {
   CHECK(children[0].reference.namespace_scopes.empty());
   CHECK(children[0].reference.local_scopes.empty());
   CHECK(children[0].reference.name == "add");
-  CHECK(children[0].children.empty());
+  CHECK(children[0].child_count == 0);
 
   CHECK(children[1].reference.name_range.contains(file.annotations().point("2")));
   CHECK(children[1].reference.uri.file() == file.path());
   CHECK(children[1].reference.namespace_scopes.empty());
   CHECK(children[1].reference.local_scopes.empty());
   CHECK(children[1].reference.name == "add");
-  CHECK(children[1].children.empty());
+  CHECK(children[1].child_count == 0);
 }
 
 TEST_CASE("find_direct_callers", "[referencer]") {
@@ -153,8 +282,56 @@ TEST_CASE("find_caller_hierarchies", "[referencer]") {
   std::optional<Reference> callee{referencer.query_location(file.path(), file.annotations().point(""))};
   REQUIRE(callee.has_value());
 
-  Reference_tree callers{referencer.find_caller_hierarchies(*callee)};
-  // FIXME: Can't test index-based operations
+  Reference_graph callers{referencer.find_caller_hierarchies(*callee)};
+}
+
+TEST_CASE("find_caller_hierarchies with index_only", "[referencer]") {
+  // clang-format off
+  Mock_file file{"foo.cpp", Annotations{R"cpp(
+                                          void ^f();
+                                          void $f[[f]]() {
+                                            $f_in_f[[f]]();
+                                          }
+                                          void $g[[g]]() {
+                                            $f_in_g[[f]]();
+                                          }
+                                        )cpp"}};
+  // clang-format on
+  auto const& annotations{file.annotations()};
+  auto const location{[&annotations](llvm::StringRef name) {
+    return make_index_location("foo.cpp", annotations.range(name));
+  }};
+  auto const function{[&location](llvm::StringRef name) {
+    return make_index_symbol(
+        "c:@F@" + name.str() + "#", "", name, clang::index::SymbolKind::Function, location(name));
+  }};
+  auto f{function("f")};
+  clang::clangd::Position const declaration{annotations.point()};
+  f.CanonicalDeclaration = make_index_location(
+      "foo.cpp",
+      clang::clangd::Range{.start{declaration}, .end{.line{declaration.line}, .character{declaration.character + 1}}});
+  auto const g{function("g")};
+  Referencer referencer{make_referencer_for_test(
+      Referencer_options{.index_only{true}},
+      make_index_for_test({f, g},
+                          {{f.ID, make_index_ref(location("f_in_f"), f.ID)},
+                           {f.ID, make_index_ref(location("f_in_g"), g.ID)}}))};
+  referencer.update_file(file.path(), annotations.code());
+
+  std::optional<Reference> callee{referencer.query_location(file.path(), annotations.point())};
+  REQUIRE(callee.has_value());
+
+  // The root is located at the declaration of `f` while the index locates its recursive call in its definition, yet
+  // `f` is one vertex and is expanded once
+  Reference_graph const callers{referencer.find_caller_hierarchies(*callee)};
+  CHECK(callers.vertex_count() == 2);
+  CHECK(callers.edge_count() == 2);
+  std::set<std::string> names;
+  for (auto const& [id, vertex] : callers.get_vertices()) {
+    CHECK(names.insert(vertex.name.str()).second);
+    CHECK_FALSE(vertex.truncated);
+  }
+  CHECK(names == std::set<std::string>{"f", "g"});
 }
 
 TEST_CASE("find_direct_supertypes", "[referencer]") {
@@ -210,8 +387,59 @@ TEST_CASE("find_supertype_hierarchies", "[referencer]") {
   std::optional<Reference> type{referencer.query_location(file.path(), file.annotations().point(""))};
   REQUIRE(type.has_value());
 
-  Reference_tree supertypes{referencer.find_supertype_hierarchies(*type)};
-  // FIXME: Can't test index-based operations
+  Reference_graph supertypes{referencer.find_supertype_hierarchies(*type)};
+}
+
+TEST_CASE("find_supertype_hierarchies with index_only", "[referencer]") {
+  // clang-format off
+  Mock_file file{"foo.cpp", Annotations{R"cpp(
+                                          class $a^A;
+                                          class $d^D;
+                                          class $A[[A]] {};
+                                          class $B[[B]] : public A {};
+                                          class $C[[C]] : public A {};
+                                          class $D[[D]] : public B, public C {};
+                                        )cpp"}};
+  // clang-format on
+  auto const& annotations{file.annotations()};
+  auto const type{[&annotations](llvm::StringRef name) {
+    return make_index_symbol("c:@S@" + name.str(),
+                             "",
+                             name,
+                             clang::index::SymbolKind::Class,
+                             make_index_location("foo.cpp", annotations.range(name)));
+  }};
+  auto const a{type("A")};
+  auto const b{type("B")};
+  auto const c{type("C")};
+  auto const d{type("D")};
+  std::vector<clang::clangd::Relation> const relations{
+      {.Subject{a.ID}, .Predicate{clang::clangd::RelationKind::BaseOf}, .Object{b.ID}},
+      {.Subject{a.ID}, .Predicate{clang::clangd::RelationKind::BaseOf}, .Object{c.ID}},
+      {.Subject{b.ID}, .Predicate{clang::clangd::RelationKind::BaseOf}, .Object{d.ID}},
+      {.Subject{c.ID}, .Predicate{clang::clangd::RelationKind::BaseOf}, .Object{d.ID}}};
+  clang::clangd::RelationSlab::Builder builder;
+  for (auto const& relation : relations) {
+    builder.insert(relation);
+  }
+  Referencer referencer{make_referencer_for_test(Referencer_options{.index_only{true}},
+                                                 make_index_for_test({a, b, c, d}, {}, relations),
+                                                 make_base_map(std::move(builder).build()))};
+  referencer.update_file(file.path(), annotations.code());
+
+  std::optional<Reference> type{referencer.query_location(file.path(), annotations.point("d"))};
+  REQUIRE(type.has_value());
+
+  // `A` is the base of both bases of `D`, and is one vertex
+  Reference_graph const types{referencer.find_supertype_hierarchies(*type)};
+  CHECK(types.vertex_count() == 4);
+  CHECK(types.edge_count() == 4);
+  std::set<std::string> names;
+  for (auto const& [id, vertex] : types.get_vertices()) {
+    CHECK(names.insert(vertex.name.str()).second);
+    CHECK_FALSE(vertex.truncated);
+  }
+  CHECK(names == std::set<std::string>{"A", "B", "C", "D"});
 }
 
 TEST_CASE("find_direct_subtypes", "[referencer]") {
@@ -266,7 +494,58 @@ TEST_CASE("find_subtype_hierarchies", "[referencer]") {
   std::optional<Reference> type{referencer.query_location(file.path(), file.annotations().point(""))};
   REQUIRE(type.has_value());
 
-  Reference_tree subtypes{referencer.find_subtype_hierarchies(*type)};
-  // FIXME: Can't test index-based operations
+  Reference_graph subtypes{referencer.find_subtype_hierarchies(*type)};
+}
+
+TEST_CASE("find_subtype_hierarchies with index_only", "[referencer]") {
+  // clang-format off
+  Mock_file file{"foo.cpp", Annotations{R"cpp(
+                                          class $a^A;
+                                          class $d^D;
+                                          class $A[[A]] {};
+                                          class $B[[B]] : public A {};
+                                          class $C[[C]] : public A {};
+                                          class $D[[D]] : public B, public C {};
+                                        )cpp"}};
+  // clang-format on
+  auto const& annotations{file.annotations()};
+  auto const type{[&annotations](llvm::StringRef name) {
+    return make_index_symbol("c:@S@" + name.str(),
+                             "",
+                             name,
+                             clang::index::SymbolKind::Class,
+                             make_index_location("foo.cpp", annotations.range(name)));
+  }};
+  auto const a{type("A")};
+  auto const b{type("B")};
+  auto const c{type("C")};
+  auto const d{type("D")};
+  std::vector<clang::clangd::Relation> const relations{
+      {.Subject{a.ID}, .Predicate{clang::clangd::RelationKind::BaseOf}, .Object{b.ID}},
+      {.Subject{a.ID}, .Predicate{clang::clangd::RelationKind::BaseOf}, .Object{c.ID}},
+      {.Subject{b.ID}, .Predicate{clang::clangd::RelationKind::BaseOf}, .Object{d.ID}},
+      {.Subject{c.ID}, .Predicate{clang::clangd::RelationKind::BaseOf}, .Object{d.ID}}};
+  clang::clangd::RelationSlab::Builder builder;
+  for (auto const& relation : relations) {
+    builder.insert(relation);
+  }
+  Referencer referencer{make_referencer_for_test(Referencer_options{.index_only{true}},
+                                                 make_index_for_test({a, b, c, d}, {}, relations),
+                                                 make_base_map(std::move(builder).build()))};
+  referencer.update_file(file.path(), annotations.code());
+
+  std::optional<Reference> type{referencer.query_location(file.path(), annotations.point("a"))};
+  REQUIRE(type.has_value());
+
+  // `D` derives from both subtypes of `A`, and is one vertex
+  Reference_graph const types{referencer.find_subtype_hierarchies(*type)};
+  CHECK(types.vertex_count() == 4);
+  CHECK(types.edge_count() == 4);
+  std::set<std::string> names;
+  for (auto const& [id, vertex] : types.get_vertices()) {
+    CHECK(names.insert(vertex.name.str()).second);
+    CHECK_FALSE(vertex.truncated);
+  }
+  CHECK(names == std::set<std::string>{"A", "B", "C", "D"});
 }
 }  // namespace cppcia
\ No newline at end of file
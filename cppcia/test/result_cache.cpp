@@ -0,0 +1,59 @@
+#include "cppcia/result_cache.hpp"
+
+#include "cppcia/frozen_graph.hpp"
+#include "cppcia/reference.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace cppcia {
+TEST_CASE("Cache_key", "[result_cache]") {
+  auto const digest_of{[](std::vector<std::string> const& parts) {
+    Cache_key key;
+    for (auto const& part : parts) {
+      key.add(part);
+    }
+    return std::move(key).digest();
+  }};
+
+  CHECK(digest_of({"foo", "bar"}) == digest_of({"foo", "bar"}));
+  CHECK(digest_of({"foo", "bar"}) != digest_of({"bar", "foo"}));
+  CHECK(digest_of({"foo", "bar"}) != digest_of({"foob", "ar"}));
+}
+
+TEST_CASE("Result_cache", "[result_cache]") {
+  auto const directory{std::filesystem::temp_directory_path() / "cppcia_test_result_cache"};
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+  auto const source{directory / "foo.cpp"};
+  std::ofstream{source} << "int foo();";
+
+  Reference const file{make_file_reference(source.string())};
+  Frozen_reference_graph const graph{std::vector<Reference>{file}, std::vector<Frozen_reference_graph::Edge_entry>{}};
+
+  Result_cache const cache{directory / "cache"};
+  CHECK(!cache.lookup("key"));
+
+  cache.store("key", graph, {source.string()});
+  auto const cached{cache.lookup("key")};
+  REQUIRE(cached);
+  REQUIRE(cached->vertex_count() == 1);
+  CHECK(cached->vertex(0) == file);
+  CHECK(!cache.lookup("other key"));
+
+  SECTION("a source changed") {
+    std::ofstream{source} << "int foo(int);";
+    CHECK(!cache.lookup("key"));
+  }
+
+  SECTION("a source can't be read") {
+    cache.store("missing", graph, {(directory / "missing.cpp").string()});
+    CHECK(!cache.lookup("missing"));
+  }
+}
+}  // namespace cppcia
\ No newline at end of file
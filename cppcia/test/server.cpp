@@ -0,0 +1,117 @@
+#include "cppcia/server.hpp"
+
+#include "cppcia/reference.hpp"
+#include "cppcia/referencer.hpp"
+#include "cppcia/test/annotations.hpp"
+#include "cppcia/test/referencer.hpp"
+
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <nlohmann/json.hpp>
+
+namespace cppcia {
+namespace {
+  // Serves `requests`, one per line, and parses every line answered
+  [[nodiscard]] auto serve(Server& server, std::vector<std::string> const& requests) -> std::vector<nlohmann::json> {
+    std::string input;
+    for (auto const& request : requests) {
+      input += request + "\n";
+    }
+    std::istringstream istream{input};
+    std::ostringstream ostream;
+    server.serve(istream, ostream);
+
+    std::vector<nlohmann::json> responses;
+    std::istringstream answered{ostream.str()};
+    for (std::string line; std::getline(answered, line);) {
+      responses.push_back(nlohmann::json::parse(line));
+    }
+    return responses;
+  }
+
+  [[nodiscard]] auto request(int id, std::string const& method, nlohmann::json params = nlohmann::json::object())
+      -> std::string {
+    return nlohmann::json{{"jsonrpc", "2.0"}, {"id", id}, {"method", method}, {"params", std::move(params)}}.dump();
+  }
+
+  [[nodiscard]] auto error_code(nlohmann::json const& response) -> Rpc_error {
+    return static_cast<Rpc_error>(response.at("error").at("code").get<int>());
+  }
+}  // namespace
+
+TEST_CASE("serve", "[server]") {
+  Referencer referencer{make_referencer_for_test()};
+  std::vector<nlohmann::json> impacted;
+  Server server{referencer,
+                [&impacted](nlohmann::json const& params) {
+                  impacted.push_back(params);
+                  if (params.contains("names_fuzzy")) {
+                    throw std::invalid_argument{"fuzzy names are not supported here"};
+                  }
+                  return Frozen_reference_graph{std::vector<Reference>{make_file_reference("/foo.cpp")},
+                                                std::vector<Frozen_reference_graph::Edge_entry>{}};
+                },
+                std::nullopt};
+
+  auto const responses{serve(server,
+                             {"not json",
+                              "",
+                              R"({"jsonrpc": "2.0", "id": 1})",
+                              request(2, "unknown"),
+                              R"({"jsonrpc": "2.0", "method": "impact", "params": {"names": ["foo"]}})",
+                              request(3, "impact", {{"names", {"foo"}}}),
+                              request(4, "impact", {{"names_fuzzy", {"foo"}}}),
+                              request(5, "exit"),
+                              request(6, "unknown")})};
+  REQUIRE(responses.size() == 6);
+
+  CHECK(responses[0].at("id").is_null());
+  CHECK(error_code(responses[0]) == Rpc_error::parse_error);
+  CHECK(responses[1].at("id") == 1);
+  CHECK(error_code(responses[1]) == Rpc_error::invalid_request);
+  CHECK(responses[2].at("id") == 2);
+  CHECK(error_code(responses[2]) == Rpc_error::method_not_found);
+
+  // The notification is neither answered nor resolved
+  REQUIRE(impacted.size() == 2);
+  CHECK(impacted[0] == nlohmann::json{{"names", {"foo"}}});
+  CHECK(responses[3].at("id") == 3);
+  REQUIRE(responses[3].at("result").is_array());
+  CHECK(responses[3].at("result").size() == 1);
+
+  CHECK(responses[4].at("id") == 4);
+  CHECK(error_code(responses[4]) == Rpc_error::invalid_params);
+
+  // Nothing is served after `exit`
+  CHECK(responses[5].at("id") == 5);
+  CHECK(responses[5].at("result").is_null());
+}
+
+TEST_CASE("serve update_file", "[server]") {
+  Referencer referencer{make_referencer_for_test()};
+  Mock_file file{"foo.cpp", Annotations{R"cpp(
+                                          int ^foo() { return 0; }
+                                        )cpp"}};
+  Mock_file updated_file{"foo.cpp", Annotations{R"cpp(
+                                          int ^bar() { return 0; }
+                                        )cpp"}};
+  referencer.update_file(file.path(), file.annotations().code());
+  Server server{referencer, [](nlohmann::json const& /*params*/) { return Frozen_reference_graph{}; }, std::nullopt};
+
+  nlohmann::json const update{{"file", file.path().str()}, {"content", updated_file.annotations().code().str()}};
+  auto const responses{
+      serve(server, {request(1, "update_file", update), request(2, "update_file", {{"content", "int baz();"}})})};
+  REQUIRE(responses.size() == 2);
+  CHECK(responses[0].at("result").is_null());
+  CHECK(error_code(responses[1]) == Rpc_error::invalid_params);
+
+  auto const reference{referencer.query_location(file.path(), updated_file.annotations().point())};
+  REQUIRE(reference.has_value());
+  CHECK(reference->name == "bar");
+}
+}  // namespace cppcia
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "cppcia/string_pool.hpp"
+
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace cppcia {
+TEST_CASE("Interned_string", "[string_pool]") {
+  std::string const foo{"foo"};
+  Interned_string const lhs{foo};
+  Interned_string const rhs{std::string{"foo"}};
+
+  CHECK(lhs == rhs);
+  CHECK(lhs.view().data() == rhs.view().data());
+  CHECK(lhs == "foo");
+  CHECK(lhs != Interned_string{"bar"});
+
+  CHECK(Interned_string{""} == Interned_string{});
+  CHECK(Interned_string{}.empty());
+}
+}  // namespace cppcia
\ No newline at end of file
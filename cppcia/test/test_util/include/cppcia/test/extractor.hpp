@@ -4,12 +4,24 @@
 #include "cppcia/extractor.hpp"
 
 #include <ctime>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include <clang/Index/IndexSymbol.h>
+#include <clangd/Protocol.h>
+#include <clangd/index/Index.h>
+#include <clangd/index/Ref.h>
+#include <clangd/index/Relation.h>
+#include <clangd/index/Symbol.h>
+#include <clangd/index/SymbolID.h>
+#include <clangd/index/SymbolLocation.h>
 #include <clangd/support/Path.h>
 #include <clangd/support/ThreadsafeFS.h>
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
 #include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
 #include <llvm/Support/Path.h>
 #include <llvm/Support/VirtualFileSystem.h>
 
@@ -26,7 +38,28 @@ class Mock_fs : public clang::clangd::ThreadsafeFS {
 auto test_root() -> char const*;
 auto test_path(clang::clangd::PathRef file, llvm::sys::path::Style = llvm::sys::path::Style::native) -> std::string;
 
-[[nodiscard]] auto make_extractor_for_test() -> cppcia::Extractor;
+// A location in `file`, which is relative as in `test_path`. Its URI is interned so that it outlives the location.
+[[nodiscard]] auto make_index_location(clang::clangd::PathRef file,
+                                       clang::clangd::Range range) -> clang::clangd::SymbolLocation;
+// A symbol declared and defined at `definition`, identified by `usr`. `scope` is as the index records it, e.g. `a::B::`
+[[nodiscard]] auto make_index_symbol(llvm::StringRef usr,
+                                     llvm::StringRef scope,
+                                     llvm::StringRef name,
+                                     clang::index::SymbolKind kind,
+                                     clang::clangd::SymbolLocation definition) -> clang::clangd::Symbol;
+[[nodiscard]] auto make_index_ref(clang::clangd::SymbolLocation location,
+                                  clang::clangd::SymbolID container,
+                                  clang::clangd::RefKind kind = clang::clangd::RefKind::Reference)
+    -> clang::clangd::Ref;
+
+// A static index of hand-made symbols, refs and relations, for the operations reading the index only
+[[nodiscard]] auto make_index_for_test(std::vector<clang::clangd::Symbol> const& symbols,
+                                       std::vector<std::pair<clang::clangd::SymbolID, clang::clangd::Ref>> const& refs,
+                                       std::vector<clang::clangd::Relation> const& relations = {})
+    -> std::unique_ptr<clang::clangd::SymbolIndex>;
+
+[[nodiscard]] auto make_extractor_for_test(std::unique_ptr<clang::clangd::SymbolIndex> symbol_index = nullptr,
+                                           Base_map bases = {}) -> cppcia::Extractor;
 }  // namespace cppcia
 
 #endif
\ No newline at end of file
@@ -1,10 +1,18 @@
 #ifndef CPPCIA_TEST_REFERENCER_HPP
 #define CPPCIA_TEST_REFERENCER_HPP
 
+#include "cppcia/extractor.hpp"
 #include "cppcia/referencer.hpp"
 
+#include <memory>
+
+#include <clangd/index/Index.h>
+
 namespace cppcia {
-[[nodiscard]] auto make_referencer_for_test() -> Referencer;
+[[nodiscard]] auto make_referencer_for_test(Referencer_options options                              = {},
+                                            std::unique_ptr<clang::clangd::SymbolIndex> symbol_index = nullptr,
+                                            Base_map bases                                           = {})
+    -> Referencer;
 }  // namespace cppcia
 
 #endif
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "cppcia/extractor.hpp"
 
+#include "cppcia/string_pool.hpp"
 #include "cppcia/test/extractor.hpp"
 
 #include <cassert>
@@ -8,10 +9,21 @@
 #include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 
+#include <clang/Index/IndexSymbol.h>
 #include <clangd/ClangdServer.h>
 #include <clangd/GlobalCompilationDatabase.h>
+#include <clangd/Protocol.h>
 #include <clangd/TUScheduler.h>
+#include <clangd/URI.h>
+#include <clangd/index/Index.h>
+#include <clangd/index/MemIndex.h>
+#include <clangd/index/Ref.h>
+#include <clangd/index/Relation.h>
+#include <clangd/index/Symbol.h>
+#include <clangd/index/SymbolID.h>
+#include <clangd/index/SymbolLocation.h>
 #include <clangd/support/Path.h>
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
 #include <llvm/ADT/SmallString.h>
@@ -64,7 +76,65 @@ auto test_path(clang::clangd::PathRef file, llvm::sys::path::Style style) -> std
   return std::string(path.str());
 }
 
-[[nodiscard]] auto make_extractor_for_test() -> cppcia::Extractor {
+[[nodiscard]] auto make_index_location(clang::clangd::PathRef file,
+                                       clang::clangd::Range range) -> clang::clangd::SymbolLocation {
+  clang::clangd::SymbolLocation result;
+  result.FileURI = intern(clang::clangd::URI::createFile(test_path(file)).toString()).data();
+  result.Start.setLine(range.start.line);
+  result.Start.setColumn(range.start.character);
+  result.End.setLine(range.end.line);
+  result.End.setColumn(range.end.character);
+  return result;
+}
+
+[[nodiscard]] auto make_index_symbol(llvm::StringRef usr,
+                                     llvm::StringRef scope,
+                                     llvm::StringRef name,
+                                     clang::index::SymbolKind kind,
+                                     clang::clangd::SymbolLocation definition) -> clang::clangd::Symbol {
+  clang::clangd::Symbol result;
+  result.ID                   = clang::clangd::SymbolID{usr};
+  result.Scope                = scope;
+  result.Name                 = name;
+  result.SymInfo.Kind         = kind;
+  result.SymInfo.Lang         = clang::index::SymbolLanguage::CXX;
+  result.Definition           = definition;
+  result.CanonicalDeclaration = definition;
+  return result;
+}
+
+[[nodiscard]] auto make_index_ref(clang::clangd::SymbolLocation location,
+                                  clang::clangd::SymbolID container,
+                                  clang::clangd::RefKind kind) -> clang::clangd::Ref {
+  clang::clangd::Ref result;
+  result.Location  = location;
+  result.Kind      = kind;
+  result.Container = container;
+  return result;
+}
+
+[[nodiscard]] auto make_index_for_test(std::vector<clang::clangd::Symbol> const& symbols,
+                                       std::vector<std::pair<clang::clangd::SymbolID, clang::clangd::Ref>> const& refs,
+                                       std::vector<clang::clangd::Relation> const& relations)
+    -> std::unique_ptr<clang::clangd::SymbolIndex> {
+  clang::clangd::SymbolSlab::Builder symbol_builder;
+  for (auto const& symbol : symbols) {
+    symbol_builder.insert(symbol);
+  }
+  clang::clangd::RefSlab::Builder ref_builder;
+  for (auto const& [id, ref] : refs) {
+    ref_builder.insert(id, ref);
+  }
+  clang::clangd::RelationSlab::Builder relation_builder;
+  for (auto const& relation : relations) {
+    relation_builder.insert(relation);
+  }
+  return clang::clangd::MemIndex::build(
+      std::move(symbol_builder).build(), std::move(ref_builder).build(), std::move(relation_builder).build());
+}
+
+[[nodiscard]] auto make_extractor_for_test(std::unique_ptr<clang::clangd::SymbolIndex> symbol_index,
+                                           Base_map bases) -> cppcia::Extractor {
   auto fs{std::make_unique<Mock_fs>()};
   clang::clangd::DirectoryBasedGlobalCompilationDatabase::Options cdb_opts(*fs);
 
@@ -76,6 +146,8 @@ auto test_path(clang::clangd::PathRef file, llvm::sys::path::Style style) -> std
   options.BuildDynamicSymbolIndex = true;
   return {std::make_unique<clang::clangd::DirectoryBasedGlobalCompilationDatabase>(std::move(cdb_opts)),
           std::move(fs),
-          std::move(options)};
+          std::move(options),
+          std::move(symbol_index),
+          std::move(bases)};
 }
 }  // namespace cppcia
\ No newline at end of file
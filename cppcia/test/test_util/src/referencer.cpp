@@ -1,10 +1,18 @@
 #include "cppcia/test/referencer.hpp"
 
+#include "cppcia/extractor.hpp"
 #include "cppcia/referencer.hpp"
 #include "cppcia/test/extractor.hpp"
 
+#include <memory>
+#include <utility>
+
+#include <clangd/index/Index.h>
+
 namespace cppcia {
-[[nodiscard]] auto make_referencer_for_test() -> Referencer {
-  return Referencer{make_extractor_for_test(), true};
+[[nodiscard]] auto make_referencer_for_test(Referencer_options options,
+                                            std::unique_ptr<clang::clangd::SymbolIndex> symbol_index,
+                                            Base_map bases) -> Referencer {
+  return Referencer{make_extractor_for_test(std::move(symbol_index), std::move(bases)), true, options};
 }
 }  // namespace cppcia
\ No newline at end of file